@@ -2,58 +2,47 @@
 // Implements encryption, decryption, and frequency-based attack on affine ciphers
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <unordered_map>
 #include <optional>
 #include <string>
+#include <tuple>
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
 
-// ============================================================================
-// Constants
-// ============================================================================
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
 
-constexpr int ALPHABET_SIZE = 26;
+#include "../common/histogram.hpp"
+#include "../common/modular-arithmetic.hpp"
+#include "../common/top-k.hpp"
 
 // ============================================================================
-// ModularArithmetic: Handles all modular arithmetic operations
+// Constants
 // ============================================================================
-// Design Decision: Separate math operations from cipher logic
-// This makes the code testable and reusable
-
-class ModularArithmetic {
-public:
-    // Finds multiplicative inverse of 'a' in Z_n
-    // Returns std::nullopt if inverse doesn't exist
-    // Design: std::optional clearly signals "might not exist"
-    static std::optional<int> findModularInverse(int a, int modulus) {
-        // Normalize 'a' to be positive
-        a = ((a % modulus) + modulus) % modulus;
-        
-        for (int i = 1; i < modulus; ++i) {
-            if ((i * a) % modulus == 1) {
-                return i;
-            }
-        }
-        return std::nullopt;
-    }
-
-    // Performs modular subtraction ensuring positive result
-    // Design: Helper function to avoid repetitive modulo arithmetic
-    static int subtract(int a, int b, int modulus) {
-        return ((a - b) % modulus + modulus) % modulus;
-    }
 
-    // Performs modular addition
-    static int add(int a, int b, int modulus) {
-        return (a + b) % modulus;
-    }
+constexpr int ALPHABET_SIZE = 26;
 
-    // Performs modular multiplication
-    static int multiply(int a, int b, int modulus) {
-        return (a * b) % modulus;
-    }
+// Relative frequencies of 'a'..'z' in English text
+constexpr double ENGLISH_FREQUENCIES[ALPHABET_SIZE] = {
+    0.08167, 0.01492, 0.02782, 0.04253, 0.12702, 0.02228, 0.02015,
+    0.06094, 0.06966, 0.00153, 0.00772, 0.04025, 0.02406, 0.06749,
+    0.07507, 0.01929, 0.00095, 0.05987, 0.06327, 0.09056, 0.02758,
+    0.00978, 0.02360, 0.00150, 0.01974, 0.00074
 };
 
+// Table-driven arithmetic in Z_26 (see common/modular-arithmetic.hpp)
+using Z26 = Zmod<ALPHABET_SIZE>;
+
 // ============================================================================
 // AffineKey: Represents the key pair (a, b) for affine cipher
 // ============================================================================
@@ -72,7 +61,9 @@ struct AffineKey {
     // Factory method: Creates key only if valid
     // Design: Static factory pattern ensures object invariants
     static std::optional<AffineKey> create(int a, int b) {
-        auto inverse = ModularArithmetic::findModularInverse(a, ALPHABET_SIZE);
+        a = Z26::reduce(a);
+        b = Z26::reduce(b);
+        auto inverse = Z26::inverse(a);
         
         if (!inverse) {
             return std::nullopt;  // 'a' has no inverse
@@ -112,6 +103,157 @@ struct KnownPlaintextPair {
     }
 };
 
+// ============================================================================
+// Crib / CribMatch: Known plaintext aligned to a position in the ciphertext
+// ============================================================================
+// Design Decision: A crib is a guessed plaintext fragment ('a'..'z'); each of
+// its letters gives one equation a*x + b = y (mod 26) against the ciphertext
+
+struct Crib {
+    std::string plaintext;
+    size_t offset;      // Position of plaintext[0] in the ciphertext
+};
+
+struct CribMatch {
+    size_t crib;        // Index into the list of dragged cribs
+    size_t offset;      // Ciphertext position where it fits
+    AffineKey key;      // The key that maps it there
+
+    void print() const {
+        std::cout << "Crib #" << crib << " at offset " << offset
+                  << ": a=" << key.a << ", b=" << key.b << "\n";
+    }
+};
+
+// ============================================================================
+// ScoredKey: A candidate key together with its fitness against English
+// ============================================================================
+// Design Decision: Lower score is better (chi-squared distance)
+
+struct ScoredKey {
+    AffineKey key;
+    double score;
+
+    void print() const {
+        std::cout << "Key: a=" << key.a << ", b=" << key.b
+                  << " (chi-squared=" << score << ")\n";
+    }
+
+    // Ranking order for TopK: lower score first, ties broken by key
+    static bool better(const ScoredKey& x, const ScoredKey& y) {
+        if (x.score != y.score) return x.score < y.score;
+        return x.key.a != y.key.a ? x.key.a < y.key.a : x.key.b < y.key.b;
+    }
+};
+
+using TopKeys = TopK<ScoredKey, decltype(&ScoredKey::better)>;
+
+// ============================================================================
+// ByteTable: 256-entry substitution table with a SIMD bulk kernel
+// ============================================================================
+// Design Decision: The affine map only accepts one contiguous run of 26 byte
+// values ('a'..'z' or 'A'..'Z'), so the vector path needs just two 16-byte
+// pshufb lookups. Bytes outside the run are passed through unchanged and
+// flagged in a separate validation bitmask instead of aborting the pass.
+
+struct ByteTable {
+    std::array<char, 256> map{};        // Image of every byte (identity if invalid)
+    std::array<bool, 256> valid{};      // Whether the byte belongs to the alphabet
+    char first = 0;                     // First byte of the valid run
+    alignas(16) char low[16] = {};      // Images of first + 0 .. first + 15
+    alignas(16) char high[16] = {};     // Images of first + 16 .. first + 25
+
+    // Builds the table for the run [first, first + ALPHABET_SIZE) from a per-byte map
+    template <typename CharMap>
+    static ByteTable build(char first, CharMap map_char) {
+        ByteTable table;
+        table.first = first;
+        for (int byte = 0; byte < 256; ++byte) {
+            char ch = static_cast<char>(byte);
+            auto mapped = map_char(ch);
+            table.valid[byte] = mapped.has_value();
+            table.map[byte] = mapped.value_or(ch);
+        }
+        for (int i = 0; i < 16; ++i) {
+            table.low[i] = table.map[static_cast<unsigned char>(first + i)];
+        }
+        for (int i = 16; i < ALPHABET_SIZE; ++i) {
+            table.high[i - 16] = table.map[static_cast<unsigned char>(first + i)];
+        }
+        return table;
+    }
+
+    // Maps in[0..n) to out[0..n). Bit i of invalid_mask is set when in[i] is
+    // outside the alphabet. Returns the number of invalid bytes.
+    size_t apply(const char* in, char* out, size_t n, std::vector<uint64_t>& invalid_mask) const {
+        invalid_mask.assign((n + 63) / 64, 0);
+        size_t invalid = 0;
+        size_t i = 0;
+
+#if defined(__AVX2__)
+        const __m256i low_table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(low)));
+        const __m256i high_table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(high)));
+        const __m256i base = _mm256_set1_epi8(first);
+        const __m256i last_low = _mm256_set1_epi8(15);
+        const __m256i last_valid = _mm256_set1_epi8(ALPHABET_SIZE - 1);
+        const __m256i sixteen = _mm256_set1_epi8(16);
+        for (; i + 32 <= n; i += 32) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            __m256i index = _mm256_sub_epi8(bytes, base);
+            __m256i is_valid = _mm256_cmpeq_epi8(_mm256_min_epu8(index, last_valid), index);
+            __m256i is_low = _mm256_cmpeq_epi8(_mm256_min_epu8(index, last_low), index);
+            __m256i from_low = _mm256_shuffle_epi8(low_table, index);
+            __m256i from_high = _mm256_shuffle_epi8(high_table, _mm256_sub_epi8(index, sixteen));
+            __m256i mapped = _mm256_blendv_epi8(from_high, from_low, is_low);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_blendv_epi8(bytes, mapped, is_valid));
+
+            uint32_t bad = ~static_cast<uint32_t>(_mm256_movemask_epi8(is_valid));
+            if (bad) {
+                invalid += std::popcount(bad);
+                invalid_mask[i / 64] |= static_cast<uint64_t>(bad) << (i % 64);
+            }
+        }
+#endif
+
+#if defined(__SSSE3__)
+        const __m128i low_table128 = _mm_load_si128(reinterpret_cast<const __m128i*>(low));
+        const __m128i high_table128 = _mm_load_si128(reinterpret_cast<const __m128i*>(high));
+        const __m128i base128 = _mm_set1_epi8(first);
+        const __m128i last_low128 = _mm_set1_epi8(15);
+        const __m128i last_valid128 = _mm_set1_epi8(ALPHABET_SIZE - 1);
+        const __m128i sixteen128 = _mm_set1_epi8(16);
+        for (; i + 16 <= n; i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            __m128i index = _mm_sub_epi8(bytes, base128);
+            __m128i is_valid = _mm_cmpeq_epi8(_mm_min_epu8(index, last_valid128), index);
+            __m128i is_low = _mm_cmpeq_epi8(_mm_min_epu8(index, last_low128), index);
+            __m128i from_low = _mm_shuffle_epi8(low_table128, index);
+            __m128i from_high = _mm_shuffle_epi8(high_table128, _mm_sub_epi8(index, sixteen128));
+            __m128i mapped = _mm_or_si128(_mm_and_si128(is_low, from_low), _mm_andnot_si128(is_low, from_high));
+            __m128i result = _mm_or_si128(_mm_and_si128(is_valid, mapped), _mm_andnot_si128(is_valid, bytes));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+
+            uint32_t bad = ~static_cast<uint32_t>(_mm_movemask_epi8(is_valid)) & 0xFFFFu;
+            if (bad) {
+                invalid += std::popcount(bad);
+                invalid_mask[i / 64] |= static_cast<uint64_t>(bad) << (i % 64);
+            }
+        }
+#endif
+
+        for (; i < n; ++i) {
+            unsigned char byte = static_cast<unsigned char>(in[i]);
+            out[i] = map[byte];
+            if (!valid[byte]) {
+                invalid++;
+                invalid_mask[i / 64] |= uint64_t{1} << (i % 64);
+            }
+        }
+
+        return invalid;
+    }
+};
+
 // ============================================================================
 // AffineCipher: Core cipher implementation
 // ============================================================================
@@ -121,6 +263,41 @@ struct KnownPlaintextPair {
 class AffineCipher {
 private:
     std::optional<AffineKey> key_;
+    std::optional<ByteTable> encrypt_table_;    // Built once per key
+    std::optional<ByteTable> decrypt_table_;
+
+    void buildTables() {
+        if (!key_) {
+            encrypt_table_.reset();
+            decrypt_table_.reset();
+            return;
+        }
+        encrypt_table_ = ByteTable::build('a', [this](char ch) { return encryptChar(ch); });
+        decrypt_table_ = ByteTable::build('A', [this](char ch) { return decryptChar(ch); });
+    }
+
+    // Runs a bulk table pass, reporting the first invalid byte like the old
+    // per-character loop did
+    static std::optional<std::string> transform(
+        const ByteTable& table,
+        const std::string& input,
+        const char* what
+    ) {
+        std::string output(input.size(), '\0');
+        std::vector<uint64_t> invalid_mask;
+        if (table.apply(input.data(), output.data(), input.size(), invalid_mask) > 0) {
+            for (size_t w = 0; w < invalid_mask.size(); ++w) {
+                if (invalid_mask[w]) {
+                    size_t pos = w * 64 + std::countr_zero(invalid_mask[w]);
+                    std::cerr << "Error: Invalid character '" << input[pos]
+                              << "' in " << what << "\n";
+                    break;
+                }
+            }
+            return std::nullopt;
+        }
+        return output;
+    }
 
     // Helper: Encrypts single character
     // Design: Private helper keeps public API clean
@@ -134,11 +311,7 @@ private:
         }
 
         int index = ch - 'a';
-        int encrypted_index = ModularArithmetic::add(
-            ModularArithmetic::multiply(key_->a, index, ALPHABET_SIZE),
-            key_->b,
-            ALPHABET_SIZE
-        );
+        int encrypted_index = Z26::add(Z26::multiply(key_->a, index), key_->b);
         
         return static_cast<char>('A' + encrypted_index);
     }
@@ -154,12 +327,8 @@ private:
         }
 
         int index = ch - 'A';
-        int shifted = ModularArithmetic::subtract(index, key_->b, ALPHABET_SIZE);
-        int decrypted_index = ModularArithmetic::multiply(
-            key_->a_inverse,
-            shifted,
-            ALPHABET_SIZE
-        );
+        int shifted = Z26::subtract(index, key_->b);
+        int decrypted_index = Z26::multiply(key_->a_inverse, shifted);
         
         return static_cast<char>('a' + decrypted_index);
     }
@@ -168,11 +337,14 @@ public:
     AffineCipher() = default;
 
     // Constructor with key
-    explicit AffineCipher(const AffineKey& key) : key_(key) {}
+    explicit AffineCipher(const AffineKey& key) : key_(key) {
+        buildTables();
+    }
 
     // Sets encryption/decryption key
     bool setKey(int a, int b) {
         key_ = AffineKey::create(a, b);
+        buildTables();
         return key_.has_value();
     }
 
@@ -191,43 +363,239 @@ public:
             return std::nullopt;
         }
 
-        std::string ciphertext;
-        ciphertext.reserve(plaintext.length());
+        return transform(*encrypt_table_, plaintext, "plaintext");
+    }
 
-        for (char ch : plaintext) {
-            auto encrypted = encryptChar(ch);
-            if (!encrypted) {
-                std::cerr << "Error: Invalid character '" << ch 
-                          << "' in plaintext\n";
-                return std::nullopt;
-            }
-            ciphertext.push_back(*encrypted);
+    // Decrypts ciphertext (uppercase) to plaintext (lowercase)
+    std::optional<std::string> decrypt(const std::string& ciphertext) const {
+        if (!key_) {
+            std::cerr << "Error: No key set for decryption\n";
+            return std::nullopt;
         }
 
-        return ciphertext;
+        return transform(*decrypt_table_, ciphertext, "ciphertext");
     }
 
-    // Decrypts ciphertext (uppercase) to plaintext (lowercase)
-    std::optional<std::string> decrypt(const std::string& ciphertext) const {
+    // Bulk encryption of n bytes into a caller-provided buffer
+    // Bytes outside 'a'..'z' are copied unchanged and flagged in invalid_mask
+    // Returns the number of invalid bytes
+    size_t encryptBulk(const char* in, char* out, size_t n, std::vector<uint64_t>& invalid_mask) const {
+        if (!key_) {
+            std::cerr << "Error: No key set for encryption\n";
+            return n;
+        }
+        return encrypt_table_->apply(in, out, n, invalid_mask);
+    }
+
+    // Bulk decryption, same contract as encryptBulk with 'A'..'Z' as the alphabet
+    size_t decryptBulk(const char* in, char* out, size_t n, std::vector<uint64_t>& invalid_mask) const {
         if (!key_) {
             std::cerr << "Error: No key set for decryption\n";
+            return n;
+        }
+        return decrypt_table_->apply(in, out, n, invalid_mask);
+    }
+};
+
+// ============================================================================
+// Alphabet: An ordered set of symbols the generalized affine map acts on
+// ============================================================================
+// Design Decision: A 256-entry index table makes symbol lookup a single load
+// for any alphabet, from a handful of letters up to all 256 byte values.
+
+enum class OutOfAlphabet {
+    Reject,         // Fail the whole message (like AffineCipher)
+    PassThrough     // Copy the character unchanged
+};
+
+class Alphabet {
+private:
+    std::string symbols_;
+    std::array<int, 256> index_;    // Position of every byte, -1 if absent
+
+    explicit Alphabet(std::string symbols) : symbols_(std::move(symbols)) {
+        index_.fill(-1);
+        for (size_t i = 0; i < symbols_.size(); ++i) {
+            index_[static_cast<unsigned char>(symbols_[i])] = static_cast<int>(i);
+        }
+    }
+
+public:
+    // Factory method: Needs at least two distinct symbols
+    static std::optional<Alphabet> create(const std::string& symbols) {
+        std::array<bool, 256> seen{};
+        for (char c : symbols) {
+            if (seen[static_cast<unsigned char>(c)]) {
+                return std::nullopt;  // Duplicate symbol
+            }
+            seen[static_cast<unsigned char>(c)] = true;
+        }
+        if (symbols.size() < 2) {
             return std::nullopt;
         }
+        return Alphabet(symbols);
+    }
 
-        std::string plaintext;
-        plaintext.reserve(ciphertext.length());
+    // 'a'..'z' followed by 'A'..'Z', digits, space and common punctuation
+    static Alphabet text() {
+        std::string symbols;
+        for (char c = 'a'; c <= 'z'; ++c) symbols.push_back(c);
+        for (char c = 'A'; c <= 'Z'; ++c) symbols.push_back(c);
+        for (char c = '0'; c <= '9'; ++c) symbols.push_back(c);
+        symbols += " .,;:!?'\"-()";
+        return Alphabet(symbols);
+    }
 
-        for (char ch : ciphertext) {
-            auto decrypted = decryptChar(ch);
-            if (!decrypted) {
-                std::cerr << "Error: Invalid character '" << ch 
-                          << "' in ciphertext\n";
+    // Every byte value in order; the affine map works mod 256
+    static Alphabet bytes() {
+        std::string symbols(256, '\0');
+        for (int i = 0; i < 256; ++i) symbols[i] = static_cast<char>(i);
+        return Alphabet(symbols);
+    }
+
+    int size() const {
+        return static_cast<int>(symbols_.size());
+    }
+
+    char symbol(int index) const {
+        return symbols_[index];
+    }
+
+    // Returns -1 if c is not in the alphabet
+    int indexOf(char c) const {
+        return index_[static_cast<unsigned char>(c)];
+    }
+
+    // Expected probability of every symbol in English text, summing to 1
+    // Letters follow ENGLISH_FREQUENCIES (mostly lowercase), spaces separate
+    // words, and everything else gets a small floor so no bin is ever empty
+    std::vector<double> englishFrequencies() const {
+        std::vector<double> expected(symbols_.size());
+        double sum = 0.0;
+        for (size_t i = 0; i < symbols_.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(symbols_[i]);
+            double weight = 1e-5;
+            if (c >= 'a' && c <= 'z') {
+                weight = 0.75 * ENGLISH_FREQUENCIES[c - 'a'];
+            } else if (c >= 'A' && c <= 'Z') {
+                weight = 0.03 * ENGLISH_FREQUENCIES[c - 'A'];
+            } else if (c == ' ') {
+                weight = 0.17;
+            } else if (c == '\n') {
+                weight = 0.005;
+            } else if (c > ' ' && c < 127) {
+                weight = 0.002;
+            }
+            expected[i] = weight;
+            sum += weight;
+        }
+        for (double& e : expected) e /= sum;
+        return expected;
+    }
+};
+
+// ============================================================================
+// AlphabetAffineCipher: Affine cipher over an arbitrary alphabet
+// ============================================================================
+// Design Decision: Symbol i maps to symbol (a*i + b) mod m, where m is the
+// alphabet size and 'a' must be coprime with m. Both directions are
+// precomputed into 256-entry byte maps when the key is set, and characters
+// outside the alphabet follow the chosen OutOfAlphabet policy, so full text
+// needs no preprocessing pass.
+
+class AlphabetAffineCipher {
+private:
+    Alphabet alphabet_;
+    OutOfAlphabet policy_;
+    std::optional<AffineKey> key_;
+    std::array<char, 256> encrypt_map_{};
+    std::array<char, 256> decrypt_map_{};
+
+    void buildMaps() {
+        if (!key_) return;
+        int m = alphabet_.size();
+        for (int byte = 0; byte < 256; ++byte) {
+            char ch = static_cast<char>(byte);
+            int index = alphabet_.indexOf(ch);
+            if (index < 0) {
+                encrypt_map_[byte] = decrypt_map_[byte] = ch;
+                continue;
+            }
+            int encrypted = static_cast<int>((1LL * key_->a * index + key_->b) % m);
+            int decrypted = static_cast<int>(1LL * key_->a_inverse * (index - key_->b + m) % m);
+            encrypt_map_[byte] = alphabet_.symbol(encrypted);
+            decrypt_map_[byte] = alphabet_.symbol(decrypted);
+        }
+    }
+
+    std::optional<std::string> transform(
+        const std::array<char, 256>& map,
+        const std::string& input,
+        const char* what
+    ) const {
+        if (!key_) {
+            std::cerr << "Error: No key set\n";
+            return std::nullopt;
+        }
+
+        std::string output(input.size(), '\0');
+        for (size_t i = 0; i < input.size(); ++i) {
+            char ch = input[i];
+            if (policy_ == OutOfAlphabet::Reject && alphabet_.indexOf(ch) < 0) {
+                std::cerr << "Error: Invalid character '" << ch << "' in " << what << "\n";
                 return std::nullopt;
             }
-            plaintext.push_back(*decrypted);
+            output[i] = map[static_cast<unsigned char>(ch)];
         }
+        return output;
+    }
 
-        return plaintext;
+public:
+    explicit AlphabetAffineCipher(Alphabet alphabet, OutOfAlphabet policy = OutOfAlphabet::PassThrough)
+        : alphabet_(std::move(alphabet)), policy_(policy) {}
+
+    AlphabetAffineCipher(Alphabet alphabet, const AffineKey& key,
+                         OutOfAlphabet policy = OutOfAlphabet::PassThrough)
+        : alphabet_(std::move(alphabet)), policy_(policy), key_(key) {
+        buildMaps();
+    }
+
+    // Creates a key for an alphabet of size m, or std::nullopt if gcd(a, m) != 1
+    static std::optional<AffineKey> createKey(int a, int b, int m) {
+        a = ((a % m) + m) % m;
+        b = ((b % m) + m) % m;
+        auto inverse = modularInverse(a, m);
+        if (!inverse) {
+            return std::nullopt;
+        }
+        return AffineKey(a, b, *inverse);
+    }
+
+    // Sets encryption/decryption key
+    bool setKey(int a, int b) {
+        key_ = createKey(a, b, alphabet_.size());
+        buildMaps();
+        return key_.has_value();
+    }
+
+    bool hasKey() const {
+        return key_.has_value();
+    }
+
+    const AffineKey& getKey() const {
+        return *key_;
+    }
+
+    const Alphabet& getAlphabet() const {
+        return alphabet_;
+    }
+
+    std::optional<std::string> encrypt(const std::string& plaintext) const {
+        return transform(encrypt_map_, plaintext, "plaintext");
+    }
+
+    std::optional<std::string> decrypt(const std::string& ciphertext) const {
+        return transform(decrypt_map_, ciphertext, "ciphertext");
     }
 };
 
@@ -256,30 +624,96 @@ public:
         int y2 = pair.ciphertext2 - 'A';
 
         // Solve: a*(x1-x2) ≡ (y1-y2) (mod 26)
-        int x_diff = ModularArithmetic::subtract(x1, x2, ALPHABET_SIZE);
-        auto x_diff_inverse = ModularArithmetic::findModularInverse(
-            x_diff, ALPHABET_SIZE
-        );
+        int x_diff = Z26::subtract(x1, x2);
+        auto x_diff_inverse = Z26::inverse(x_diff);
 
         if (!x_diff_inverse) {
             return std::nullopt;  // No solution exists
         }
 
-        int y_diff = ModularArithmetic::subtract(y1, y2, ALPHABET_SIZE);
-        int a = ModularArithmetic::multiply(y_diff, *x_diff_inverse, ALPHABET_SIZE);
+        int y_diff = Z26::subtract(y1, y2);
+        int a = Z26::multiply(y_diff, *x_diff_inverse);
 
         // Solve: b ≡ y1 - a*x1 (mod 26)
-        int b = ModularArithmetic::subtract(
-            y1,
-            ModularArithmetic::multiply(a, x1, ALPHABET_SIZE),
-            ALPHABET_SIZE
-        );
+        int b = Z26::subtract(y1, Z26::multiply(a, x1));
 
         return AffineKey::create(a, b);
     }
 
+    // Solves for every key consistent with all the given cribs at once
+    // Usually returns one key, none if the cribs contradict each other, and
+    // several only if the cribs cannot pin the key down (e.g. a single letter)
+    static std::vector<AffineKey> solveCribs(
+        const std::string& ciphertext,
+        const std::vector<Crib>& cribs
+    ) {
+        std::vector<int> x, y;
+        for (const Crib& crib : cribs) {
+            if (!appendEquations(ciphertext, crib.plaintext, crib.offset, x, y)) {
+                return {};
+            }
+        }
+        return solveEquations(x.data(), y.data(), x.size());
+    }
+
+    // Crib dragging: slides each crib across the ciphertext and reports every
+    // offset where a single key maps it onto the ciphertext
+    // Design: The pair of crib letters used to solve for the key only depends
+    // on the crib, so it is chosen once; each offset then costs one solve
+    // plus a check of the remaining letters that stops at the first mismatch.
+    static std::vector<CribMatch> dragCribs(
+        const std::string& ciphertext,
+        const std::vector<std::string>& cribs
+    ) {
+        std::vector<CribMatch> matches;
+        std::vector<int> x, y;
+
+        for (size_t index = 0; index < cribs.size(); ++index) {
+            const std::string& crib = cribs[index];
+            if (crib.empty() || crib.size() > ciphertext.size()) continue;
+
+            x.clear();
+            for (char p : crib) {
+                if (p < 'a' || p > 'z') break;
+                x.push_back(p - 'a');
+            }
+            if (x.size() != crib.size()) continue;  // Not a plaintext crib
+
+            auto pivot = findPivot(x.data(), x.size());
+            y.resize(x.size());
+
+            for (size_t offset = 0; offset + crib.size() <= ciphertext.size(); ++offset) {
+                bool letters = true;
+                for (size_t i = 0; i < crib.size() && letters; ++i) {
+                    char c = ciphertext[offset + i];
+                    letters = c >= 'A' && c <= 'Z';
+                    y[i] = c - 'A';
+                }
+                if (!letters) continue;
+
+                if (pivot) {
+                    auto [i, j, inverse] = *pivot;
+                    int a = Z26::multiply(Z26::subtract(y[i], y[j]), inverse);
+                    int b = Z26::subtract(y[i], Z26::multiply(a, x[i]));
+                    if (Z26::isUnit(a) && satisfies(a, b, x.data(), y.data(), x.size())) {
+                        matches.push_back({index, offset, AffineKey(a, b, *Z26::inverse(a))});
+                    }
+                } else {
+                    for (const AffineKey& key : solveEquations(x.data(), y.data(), x.size())) {
+                        matches.push_back({index, offset, key});
+                    }
+                }
+            }
+        }
+
+        return matches;
+    }
+
     // Performs frequency analysis attack on ciphertext
     // Tries different mappings of frequent ciphertext letters to frequent plaintext letters
+    // and returns up to max_results plaintexts, most English-like first.
+    // Design: Every candidate key is scored from one ciphertext histogram
+    // (see chiSquared), and only the max_results survivors are ever decrypted.
     static std::vector<std::string> frequencyAttack(
         const std::string& ciphertext,
         const std::vector<char>& likely_plaintext_chars = {'e', 't', 'a', 'o'},
@@ -292,9 +726,12 @@ public:
         for (char c : frequent_ciphertext) std::cout << c << " ";
         std::cout << "\n\n";
 
-        // Step 2: Try different mappings
-        std::vector<std::string> candidates;
-        AffineCipher cipher;
+        int counts[ALPHABET_SIZE] = {};
+        int total = countLetters(ciphertext, counts);
+
+        // Step 2: Score different mappings, each distinct key once
+        TopKeys best(static_cast<size_t>(std::max(max_results, 0)), &ScoredKey::better);
+        bool seen[ALPHABET_SIZE * ALPHABET_SIZE] = {};
 
         for (char c1 : frequent_ciphertext) {
             for (char c2 : frequent_ciphertext) {
@@ -307,52 +744,349 @@ public:
                         KnownPlaintextPair pair(p1, c1, p2, c2);
                         auto key = solveAffineParameters(pair);
 
-                        if (!key) continue;
-
-                        cipher = AffineCipher(*key);
-                        auto decrypted = cipher.decrypt(ciphertext);
+                        if (!key || seen[key->a * ALPHABET_SIZE + key->b]) continue;
+                        seen[key->a * ALPHABET_SIZE + key->b] = true;
 
-                        if (decrypted) {
-                            candidates.push_back(*decrypted);
-                            
-                            if (candidates.size() >= max_results) {
-                                return candidates;
-                            }
-                        }
+                        best.push({*key, chiSquared(counts, total, key->a, key->b)});
                     }
                 }
             }
         }
 
+        // Step 3: Decrypt the survivors only
+        std::vector<std::string> candidates;
+        candidates.reserve(best.size());
+        for (const ScoredKey& scored : best.ranked()) {
+            auto decrypted = AffineCipher(scored.key).decrypt(ciphertext);
+            if (!decrypted) break;  // Invalid ciphertext fails for every key
+            candidates.push_back(std::move(*decrypted));
+        }
+
         return candidates;
     }
 
+    // Scores every one of the 12 * 26 valid keys against English letter statistics
+    // and returns the best `top_k`, best first.
+    // Design: Every key is scored off one 26-bin ciphertext histogram (see
+    // chiSquared); no candidate plaintext is ever built.
+    // `threads` is passed on to the histogram; callers that already run one
+    // attack per thread pass 1.
+    static std::vector<ScoredKey> exhaustiveAttack(
+        const std::string& ciphertext,
+        size_t top_k = 5,
+        unsigned threads = std::thread::hardware_concurrency()
+    ) {
+        int counts[ALPHABET_SIZE] = {};
+        int total = countLetters(ciphertext, counts, threads);
+
+        TopKeys best(top_k, &ScoredKey::better);
+        if (total == 0) {
+            return best.ranked();
+        }
+
+        for (int a : Z26::units()) {
+            for (int b = 0; b < ALPHABET_SIZE; ++b) {
+                AffineKey key(a, b, *Z26::inverse(a));
+                best.push({key, chiSquared(counts, total, a, b)});
+            }
+        }
+
+        return best.ranked();
+    }
+
+    // Generalized exhaustive search: scores every key (a, b) with gcd(a, m) = 1
+    // over an arbitrary alphabet of size m (m * phi(m) keys, 32768 for bytes)
+    // and returns the best `top_k`, best first.
+    // Design: Same chi-squared ranking as above, against the alphabet's own
+    // expected distribution. Symbols outside the alphabet are ignored.
+    static std::vector<ScoredKey> exhaustiveAttack(
+        const std::string& ciphertext,
+        const Alphabet& alphabet,
+        size_t top_k = 5
+    ) {
+        const int m = alphabet.size();
+        ByteHistogram histogram(ciphertext);
+        std::vector<int> counts(m, 0);
+        int total = 0;
+        for (int i = 0; i < m; ++i) {
+            counts[i] = static_cast<int>(histogram[static_cast<unsigned char>(alphabet.symbol(i))]);
+            total += counts[i];
+        }
+
+        TopKeys best(top_k, &ScoredKey::better);
+        if (total == 0) {
+            return best.ranked();
+        }
+
+        std::vector<double> expected = alphabet.englishFrequencies();
+        for (double& e : expected) e *= total;
+
+        for (int a = 1; a < m; ++a) {
+            auto a_inverse = modularInverse(a, m);
+            if (!a_inverse) continue;
+
+            for (int b = 0; b < m; ++b) {
+                // Walk c = a*p + b (mod m) incrementally instead of using '%'
+                double chi_squared = 0.0;
+                int c = b;
+                for (int p = 0; p < m; ++p) {
+                    double diff = counts[c] - expected[p];
+                    chi_squared += diff * diff / expected[p];
+                    c += a;
+                    if (c >= m) c -= m;
+                }
+                best.push({AffineKey(a, b, *a_inverse), chi_squared});
+            }
+        }
+
+        return best.ranked();
+    }
+
 private:
+    // Turns a crib into equations x[i] -> y[i]; false if it does not fit the ciphertext
+    static bool appendEquations(
+        const std::string& ciphertext,
+        const std::string& plaintext,
+        size_t offset,
+        std::vector<int>& x,
+        std::vector<int>& y
+    ) {
+        if (offset > ciphertext.size() || plaintext.size() > ciphertext.size() - offset) {
+            return false;
+        }
+        for (size_t i = 0; i < plaintext.size(); ++i) {
+            char p = plaintext[i];
+            char c = ciphertext[offset + i];
+            if (p < 'a' || p > 'z' || c < 'A' || c > 'Z') {
+                return false;
+            }
+            x.push_back(p - 'a');
+            y.push_back(c - 'A');
+        }
+        return true;
+    }
+
+    // Finds two equations whose plaintext difference is invertible mod 26
+    // Returns (i, j, (x[i] - x[j])^-1), or std::nullopt if there is none
+    static std::optional<std::tuple<size_t, size_t, int>> findPivot(const int* x, size_t n) {
+        for (size_t j = 1; j < n; ++j) {
+            auto inverse = Z26::inverse(Z26::subtract(x[0], x[j]));
+            if (inverse) {
+                return std::make_tuple(size_t{0}, j, *inverse);
+            }
+        }
+        // Every difference to x[0] shares a factor with 26; a pair of the
+        // remaining letters may still differ by a unit (e.g. x[0] = 0, 2, 13)
+        for (size_t i = 1; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j) {
+                auto inverse = Z26::inverse(Z26::subtract(x[i], x[j]));
+                if (inverse) {
+                    return std::make_tuple(i, j, *inverse);
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    static bool satisfies(int a, int b, const int* x, const int* y, size_t n) {
+        for (size_t k = 0; k < n; ++k) {
+            if (Z26::add(Z26::multiply(a, x[k]), b) != y[k]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // All keys with a*x[k] + b = y[k] (mod 26) for every k
+    // Design: Solve directly from a pivot pair when there is one; otherwise
+    // the system is underdetermined mod 2 or mod 13, so try each of the 12
+    // valid values of 'a' (b then follows from the first equation)
+    static std::vector<AffineKey> solveEquations(const int* x, const int* y, size_t n) {
+        std::vector<AffineKey> keys;
+        if (n == 0) {
+            return keys;
+        }
+
+        if (auto pivot = findPivot(x, n)) {
+            auto [i, j, inverse] = *pivot;
+            int a = Z26::multiply(Z26::subtract(y[i], y[j]), inverse);
+            int b = Z26::subtract(y[i], Z26::multiply(a, x[i]));
+            if (Z26::isUnit(a) && satisfies(a, b, x, y, n)) {
+                keys.emplace_back(a, b, *Z26::inverse(a));
+            }
+            return keys;
+        }
+
+        for (int a : Z26::units()) {
+            int b = Z26::subtract(y[0], Z26::multiply(a, x[0]));
+            if (satisfies(a, b, x, y, n)) {
+                keys.emplace_back(a, b, *Z26::inverse(a));
+            }
+        }
+        return keys;
+    }
+
+    // Fills counts with the 'A'..'Z' histogram of text and returns the number of letters
+    static int countLetters(
+        const std::string& text,
+        int (&counts)[ALPHABET_SIZE],
+        unsigned threads = std::thread::hardware_concurrency()
+    ) {
+        auto letters = ByteHistogram(text, threads).letters<ALPHABET_SIZE>('A');
+        int total = 0;
+        for (int i = 0; i < ALPHABET_SIZE; ++i) {
+            counts[i] = static_cast<int>(letters[i]);
+            total += counts[i];
+        }
+        return total;
+    }
+
+    // Chi-squared distance between the plaintext key (a, b) would produce and English
+    // Plaintext letter p encrypts to (a*p + b) mod 26, so decrypting permutes the
+    // ciphertext histogram; the plaintext itself is never built
+    static double chiSquared(const int (&counts)[ALPHABET_SIZE], int total, int a, int b) {
+        double chi_squared = 0.0;
+        if (total == 0) {
+            return chi_squared;
+        }
+        for (int p = 0; p < ALPHABET_SIZE; ++p) {
+            int c = Z26::add(Z26::multiply(a, p), b);
+            double expected = total * ENGLISH_FREQUENCIES[p];
+            double diff = counts[c] - expected;
+            chi_squared += diff * diff / expected;
+        }
+        return chi_squared;
+    }
+
     // Analyzes character frequency in text
     static std::vector<char> getFrequentCharacters(
         const std::string& text,
         size_t count
     ) {
-        std::unordered_map<char, int> freq;
-        
-        for (char c : text) {
-            freq[c]++;
+        return ByteHistogram(text).mostFrequent(count);
+    }
+};
+
+// ============================================================================
+// AffineBatchCracker: Cracks a stream of independent ciphertexts
+// ============================================================================
+// Design Decision: One set of worker threads lives for the whole run. Each
+// worker takes the next block of lines from the input (blocks are numbered from
+// a shared counter as they are read), cracks it on its own thread, and hands the
+// records to the calling thread, which writes the blocks out in input order.
+// Workers may read at most 2 blocks per thread ahead of the writer, so memory
+// stays proportional to the block size however large the input is. Every line
+// is cracked single-threaded, so no nested thread pools are started.
+
+class AffineBatchCracker {
+private:
+    unsigned threads_;
+    size_t block_lines_;
+
+    // Cracks one ciphertext line into a "a:b,plaintext,score" record
+    // Lowercase letters are upper-cased, everything else is dropped
+    static std::string crackLine(const std::string& line) {
+        std::string ciphertext;
+        ciphertext.reserve(line.size());
+        for (char c : line) {
+            if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+            if (c >= 'A' && c <= 'Z') ciphertext.push_back(c);
         }
 
-        // Sort by frequency
-        std::vector<std::pair<char, int>> freq_vec(freq.begin(), freq.end());
-        std::sort(freq_vec.begin(), freq_vec.end(),
-            [](const auto& a, const auto& b) {
-                return a.second > b.second;  // Descending order
-            });
+        auto ranked = AffineCryptanalysis::exhaustiveAttack(ciphertext, 1, 1);
+        if (ranked.empty()) {
+            return "-,,";
+        }
+
+        const ScoredKey& best = ranked.front();
+        auto plaintext = AffineCipher(best.key).decrypt(ciphertext);
+
+        std::ostringstream record;
+        record << best.key.a << ':' << best.key.b << ','
+               << plaintext.value_or("") << ',' << best.score;
+        return record.str();
+    }
+
+public:
+    explicit AffineBatchCracker(
+        unsigned threads = std::thread::hardware_concurrency(),
+        size_t block_lines = 4096
+    ) : threads_(std::max(1u, threads)), block_lines_(std::max<size_t>(1, block_lines)) {}
+
+    // Reads newline-delimited ciphertexts from 'in' and writes one record per line
+    // to 'out', in input order. Returns the number of records written.
+    size_t run(std::istream& in, std::ostream& out) const {
+        const size_t window = 2 * static_cast<size_t>(threads_);
+
+        std::mutex m;
+        std::condition_variable cv;
+        // Cracked blocks waiting to be written; block b lives in slot b % window
+        std::vector<std::optional<std::vector<std::string>>> pending(window);
+        size_t blocks_read = 0;
+        size_t blocks_written = 0;
+        bool exhausted = false;     // No more blocks will be read; blocks_read is final
+
+        auto worker = [&]() {
+            std::vector<std::string> lines;
+            while (true) {
+                size_t block;
+                {
+                    std::unique_lock<std::mutex> lock(m);
+                    cv.wait(lock, [&] { return exhausted || blocks_read < blocks_written + window; });
+                    if (exhausted) return;
+
+                    lines.clear();
+                    std::string line;
+                    while (lines.size() < block_lines_ && std::getline(in, line)) {
+                        lines.push_back(std::move(line));
+                    }
+                    if (lines.size() < block_lines_) {
+                        exhausted = true;
+                        cv.notify_all();
+                    }
+                    if (lines.empty()) return;
+                    block = blocks_read++;
+                }
 
-        // Extract top characters
-        std::vector<char> result;
-        for (size_t i = 0; i < std::min(count, freq_vec.size()); ++i) {
-            result.push_back(freq_vec[i].first);
+                std::vector<std::string> records(lines.size());
+                for (size_t i = 0; i < lines.size(); ++i) {
+                    records[i] = crackLine(lines[i]);
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(m);
+                    pending[block % window] = std::move(records);
+                }
+                cv.notify_all();
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads_; ++t) pool.emplace_back(worker);
+
+        size_t written = 0;
+        for (size_t block = 0;; ++block) {
+            std::vector<std::string> records;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                auto& slot = pending[block % window];
+                cv.wait(lock, [&] { return slot.has_value() || (exhausted && block >= blocks_read); });
+                if (!slot) break;
+                records = std::move(*slot);
+                slot.reset();
+                ++blocks_written;
+            }
+            cv.notify_all();
+
+            for (const auto& record : records) {
+                out << record << '\n';
+            }
+            out.flush();
+            written += records.size();
         }
 
-        return result;
+        for (auto& t : pool) t.join();
+        return written;
     }
 };
 
@@ -360,7 +1094,24 @@ private:
 // Main: Demonstrates usage
 // ============================================================================
 
-int main() {
+// Usage: affine                  runs the demonstration below
+//        affine --batch [file]   cracks one ciphertext per line of 'file' (or stdin)
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::string(argv[1]) == "--batch") {
+        AffineBatchCracker cracker;
+        if (argc >= 3) {
+            std::ifstream in(argv[2]);
+            if (!in) {
+                std::cerr << "Error: Cannot open " << argv[2] << "\n";
+                return 1;
+            }
+            cracker.run(in, std::cout);
+        } else {
+            cracker.run(std::cin, std::cout);
+        }
+        return 0;
+    }
+
     std::cout << "===== Affine Cipher Cryptanalysis =====\n\n";
 
     const std::string ciphertext = 
@@ -378,5 +1129,50 @@ int main() {
         std::cout << i + 1 << ". " << candidates[i] << "\n";
     }
 
+    // Perform exhaustive attack
+    std::cout << "\nPerforming exhaustive key search...\n";
+    auto ranked = AffineCryptanalysis::exhaustiveAttack(ciphertext, 5);
+
+    std::cout << "\nBest keys:\n";
+    std::cout << "----------------------------------------\n";
+    for (size_t i = 0; i < ranked.size(); ++i) {
+        std::cout << i + 1 << ". ";
+        ranked[i].print();
+        auto decrypted = AffineCipher(ranked[i].key).decrypt(ciphertext);
+        if (decrypted) {
+            std::cout << "   " << *decrypted << "\n";
+        }
+    }
+
+    // Crib dragging: where could "arithmetic" sit in the ciphertext?
+    std::cout << "\nDragging cribs across the ciphertext...\n";
+    for (const auto& match : AffineCryptanalysis::dragCribs(ciphertext, {"arithmetic", "process"})) {
+        match.print();
+    }
+
+    // Full-text messages: no preprocessing, punctuation and digits are part of the alphabet
+    std::cout << "\nPerforming exhaustive key search over full text...\n";
+    const std::string message =
+        "Affine ciphers over larger alphabets keep spaces, digits and punctuation. "
+        "Captured traffic can be attacked as it is, without stripping it first; "
+        "the key space grows, but scoring a key still costs a single histogram pass.";
+
+    for (const Alphabet& alphabet : {Alphabet::text(), Alphabet::bytes()}) {
+        AlphabetAffineCipher sender(alphabet);
+        sender.setKey(alphabet.size() == 256 ? 167 : 31, 42);
+        auto sent = sender.encrypt(message);
+        if (!sent) continue;
+
+        auto best = AffineCryptanalysis::exhaustiveAttack(*sent, alphabet, 1);
+        if (best.empty()) continue;
+
+        std::cout << "\nAlphabet of " << alphabet.size() << " symbols, best ";
+        best.front().print();
+        auto recovered = AlphabetAffineCipher(alphabet, best.front().key).decrypt(*sent);
+        if (recovered) {
+            std::cout << "   " << *recovered << "\n";
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
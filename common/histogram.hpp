@@ -0,0 +1,141 @@
+// Shared byte histogram kernel for the cipher tools.
+// Counting is the first stage of every frequency attack, so it uses fixed
+// arrays instead of hash maps and splits large inputs across threads.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "top-k.hpp"
+
+// ============================================================================
+// ByteHistogram: Occurrences of every byte value in a text
+// ============================================================================
+// Design Decision: Consecutive equal bytes (common in ciphertext and padding)
+// would make every increment wait for the previous store to the same counter.
+// Spreading the stream over BANKS independent counter tables breaks that
+// dependency chain; the banks are summed once at the end.
+
+class ByteHistogram {
+public:
+    static constexpr int BANKS = 4;
+    static constexpr size_t PARALLEL_THRESHOLD = size_t{1} << 20;  // Below this, threads cost more than they save
+
+private:
+    std::array<uint64_t, 256> counts_{};
+    uint64_t total_ = 0;
+
+    // Single-threaded multi-bank count of [data, data + n)
+    void countSerial(const unsigned char* data, size_t n) {
+        // 32-bit banks are flushed before they could overflow
+        constexpr size_t FLUSH_EVERY = size_t{1} << 30;
+        std::array<std::array<uint32_t, 256>, BANKS> banks{};
+
+        size_t i = 0;
+        while (i < n) {
+            size_t stop = std::min(n, i + FLUSH_EVERY);
+            for (; i + BANKS <= stop; i += BANKS) {
+                for (int b = 0; b < BANKS; ++b) {
+                    banks[b][data[i + b]]++;
+                }
+            }
+            for (; i < stop; ++i) {
+                banks[0][data[i]]++;
+            }
+            for (auto& bank : banks) {
+                for (int v = 0; v < 256; ++v) counts_[v] += bank[v];
+                bank.fill(0);
+            }
+        }
+        total_ += n;
+    }
+
+public:
+    ByteHistogram() = default;
+
+    // Counts text; inputs of at least PARALLEL_THRESHOLD bytes are split into
+    // one slice per thread and the per-thread histograms are summed
+    explicit ByteHistogram(std::string_view text, unsigned threads = std::thread::hardware_concurrency()) {
+        add(text, threads);
+    }
+
+    void add(std::string_view text, unsigned threads = std::thread::hardware_concurrency()) {
+        const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+        size_t n = text.size();
+        threads = std::max(1u, threads);
+
+        if (n < PARALLEL_THRESHOLD || threads == 1) {
+            countSerial(data, n);
+            return;
+        }
+
+        std::vector<ByteHistogram> partial(threads);
+        std::vector<std::thread> pool;
+        size_t slice = (n + threads - 1) / threads;
+        for (unsigned t = 0; t < threads; ++t) {
+            size_t begin = std::min(n, t * slice);
+            size_t end = std::min(n, begin + slice);
+            pool.emplace_back([&partial, data, begin, end, t] {
+                partial[t].countSerial(data + begin, end - begin);
+            });
+        }
+        for (auto& worker : pool) worker.join();
+        for (const auto& h : partial) merge(h);
+    }
+
+    // Counts every stride-th byte starting at offset, e.g. one column of a
+    // periodic (Vigenere) ciphertext
+    void addStrided(std::string_view text, size_t offset, size_t stride) {
+        for (size_t i = offset; i < text.size(); i += stride) {
+            counts_[static_cast<unsigned char>(text[i])]++;
+            total_++;
+        }
+    }
+
+    // Adds the counts of another histogram (the reduce step)
+    void merge(const ByteHistogram& other) {
+        for (int v = 0; v < 256; ++v) counts_[v] += other.counts_[v];
+        total_ += other.total_;
+    }
+
+    uint64_t operator[](unsigned char byte) const {
+        return counts_[byte];
+    }
+
+    uint64_t total() const {
+        return total_;
+    }
+
+    // Counts of the `size` consecutive byte values starting at `first`,
+    // e.g. letters<26>('A') for an uppercase alphabet
+    template <size_t Size>
+    std::array<uint64_t, Size> letters(char first) const {
+        std::array<uint64_t, Size> result{};
+        for (size_t i = 0; i < Size; ++i) {
+            result[i] = counts_[static_cast<unsigned char>(first + i)];
+        }
+        return result;
+    }
+
+    // The `count` most frequent bytes that occur at all, most frequent first
+    // (ties broken by the smaller byte value first)
+    std::vector<char> mostFrequent(size_t count) const {
+        auto better = [this](int x, int y) {
+            return counts_[x] != counts_[y] ? counts_[x] > counts_[y] : x < y;
+        };
+        TopK<int, decltype(better)> best(count, better);
+        for (int v = 0; v < 256; ++v) {
+            if (counts_[v] > 0) best.push(v);
+        }
+
+        std::vector<char> result;
+        for (int v : best.ranked()) result.push_back(static_cast<char>(v));
+        return result;
+    }
+};
@@ -0,0 +1,120 @@
+// Shared modular arithmetic for the cipher tools.
+// Every table is generated at compile time, so the inner loops of key searches
+// become plain array lookups instead of '%' operations and inverse scans.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+// ============================================================================
+// Zmod<Modulus>: Add, multiply and inverse tables for the ring Z_Modulus
+// ============================================================================
+// Design Decision: Templated on the modulus so 26-letter, 29-letter and
+// byte-level (256) alphabets share one implementation. Entries fit in a byte,
+// which keeps even the 256 x 256 tables at 64 KiB each.
+
+template <int Modulus>
+class Zmod {
+    static_assert(Modulus >= 2 && Modulus <= 256, "Zmod supports moduli in [2, 256]");
+
+    using Table = std::array<uint8_t, Modulus * Modulus>;
+
+    static constexpr Table makeAddTable() {
+        Table table{};
+        for (int a = 0; a < Modulus; ++a)
+            for (int b = 0; b < Modulus; ++b)
+                table[a * Modulus + b] = static_cast<uint8_t>((a + b) % Modulus);
+        return table;
+    }
+
+    static constexpr Table makeMultiplyTable() {
+        Table table{};
+        for (int a = 0; a < Modulus; ++a)
+            for (int b = 0; b < Modulus; ++b)
+                table[a * Modulus + b] = static_cast<uint8_t>((a * b) % Modulus);
+        return table;
+    }
+
+    // 0 marks "no inverse"; 0 itself is never a unit for Modulus >= 2
+    static constexpr std::array<uint8_t, Modulus> makeInverseTable() {
+        std::array<uint8_t, Modulus> table{};
+        for (int a = 1; a < Modulus; ++a)
+            for (int i = 1; i < Modulus; ++i)
+                if ((a * i) % Modulus == 1) {
+                    table[a] = static_cast<uint8_t>(i);
+                    break;
+                }
+        return table;
+    }
+
+    static constexpr Table ADD = makeAddTable();
+    static constexpr Table MULTIPLY = makeMultiplyTable();
+    static constexpr std::array<uint8_t, Modulus> INVERSE = makeInverseTable();
+
+    static constexpr int countUnits() {
+        int count = 0;
+        for (int a = 0; a < Modulus; ++a)
+            if (INVERSE[a] != 0) ++count;
+        return count;
+    }
+
+public:
+    static constexpr int MODULUS = Modulus;
+    static constexpr int UNIT_COUNT = countUnits();
+
+    // Brings any integer into [0, Modulus)
+    static constexpr int reduce(int a) {
+        return ((a % Modulus) + Modulus) % Modulus;
+    }
+
+    // The operations below expect operands already in [0, Modulus)
+    static constexpr int add(int a, int b) {
+        return ADD[a * Modulus + b];
+    }
+
+    static constexpr int subtract(int a, int b) {
+        return ADD[a * Modulus + (b == 0 ? 0 : Modulus - b)];
+    }
+
+    static constexpr int multiply(int a, int b) {
+        return MULTIPLY[a * Modulus + b];
+    }
+
+    static constexpr bool isUnit(int a) {
+        return INVERSE[a] != 0;
+    }
+
+    // Returns std::nullopt if 'a' has no inverse
+    static constexpr std::optional<int> inverse(int a) {
+        if (!isUnit(a)) return std::nullopt;
+        return INVERSE[a];
+    }
+
+    // All invertible elements in increasing order
+    static constexpr std::array<uint8_t, UNIT_COUNT> units() {
+        std::array<uint8_t, UNIT_COUNT> result{};
+        int next = 0;
+        for (int a = 0; a < Modulus; ++a)
+            if (INVERSE[a] != 0) result[next++] = static_cast<uint8_t>(a);
+        return result;
+    }
+};
+
+// ============================================================================
+// Runtime helpers for moduli only known at run time
+// ============================================================================
+
+// Extended Euclid; returns std::nullopt if gcd(a, modulus) != 1
+constexpr std::optional<int> modularInverse(int a, int modulus) {
+    long long old_r = ((a % modulus) + modulus) % modulus, r = modulus;
+    long long old_s = 1, s = 0;
+    while (r != 0) {
+        long long q = old_r / r;
+        long long t = old_r - q * r; old_r = r; r = t;
+        t = old_s - q * s; old_s = s; s = t;
+    }
+    if (old_r != 1) return std::nullopt;
+    return static_cast<int>(((old_s % modulus) + modulus) % modulus);
+}
@@ -0,0 +1,193 @@
+// Shared n-gram counter for the cipher tools.
+// k-grams are packed into base-26 integers with a rolling update, so counting
+// never builds a string or hashes one.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "histogram.hpp"
+#include "top-k.hpp"
+
+// ============================================================================
+// NGramCounter: Occurrences of every k-gram of 26 consecutive letters
+// ============================================================================
+// Design Decision: For k <= DENSE_MAX_K the counts live in a dense array
+// indexed by the code (26^4 = 456,976 slots, under 2 MiB), so counting is one
+// increment per position. Longer grams are too sparse for that and go to an
+// open-addressing hash table of (code, count) pairs, which needs no per-gram
+// allocation. Monograms use ByteHistogram directly.
+
+struct NGramCount {
+    uint64_t code;      // Base-26 packing, first letter most significant
+    uint32_t count;
+};
+
+class NGramCounter {
+public:
+    static constexpr int DENSE_MAX_K = 4;
+    static constexpr int MAX_K = 13;    // 26^13 < 2^64
+
+private:
+    int k_;
+    char first_;                // First letter of the alphabet ('a' or 'A')
+    uint64_t size_;             // 26^k possible grams
+    std::vector<uint32_t> dense_;
+    std::vector<NGramCount> sparse_;    // Linear probing; code + 1 stored, 0 = empty slot
+    size_t sparse_used_ = 0;
+
+    static size_t slotOf(uint64_t code, size_t mask) {
+        return static_cast<size_t>((code * 0x9E3779B97F4A7C15ull) >> 20) & mask;
+    }
+
+    void growSparse() {
+        std::vector<NGramCount> old = std::move(sparse_);
+        sparse_.assign(std::max<size_t>(1024, old.size() * 2), NGramCount{0, 0});
+        size_t mask = sparse_.size() - 1;
+        for (const NGramCount& entry : old) {
+            if (entry.code == 0) continue;
+            size_t slot = slotOf(entry.code - 1, mask);
+            while (sparse_[slot].code != 0) slot = (slot + 1) & mask;
+            sparse_[slot] = entry;
+        }
+    }
+
+    void incrementSparse(uint64_t code) {
+        if (2 * (sparse_used_ + 1) > sparse_.size()) {
+            growSparse();
+        }
+        size_t mask = sparse_.size() - 1;
+        size_t slot = slotOf(code, mask);
+        while (sparse_[slot].code != 0 && sparse_[slot].code != code + 1) {
+            slot = (slot + 1) & mask;
+        }
+        if (sparse_[slot].code == 0) {
+            sparse_[slot].code = code + 1;
+            ++sparse_used_;
+        }
+        sparse_[slot].count++;
+    }
+
+    bool isDense() const {
+        return k_ <= DENSE_MAX_K;
+    }
+
+    int digit(char c) const {
+        unsigned d = static_cast<unsigned char>(c) - static_cast<unsigned char>(first_);
+        return d < 26 ? static_cast<int>(d) : -1;
+    }
+
+public:
+    // k is clamped to [1, MAX_K]
+    explicit NGramCounter(int k, char first = 'a') : k_(std::clamp(k, 1, MAX_K)), first_(first), size_(1) {
+        for (int i = 0; i < k_; ++i) size_ *= 26;
+        if (isDense()) {
+            dense_.assign(size_, 0);
+        }
+    }
+
+    // Counts every k-gram of consecutive letters in text
+    // A character outside the alphabet ends the current run of letters
+    void add(std::string_view text) {
+        if (k_ == 1) {
+            ByteHistogram histogram(text);
+            for (int d = 0; d < 26; ++d) {
+                dense_[d] += static_cast<uint32_t>(histogram[static_cast<unsigned char>(first_ + d)]);
+            }
+            return;
+        }
+
+        const uint64_t high = size_ / 26;   // Weight of the oldest letter
+        uint64_t code = 0;
+        int run = 0;                        // Letters in the current window
+        for (size_t i = 0; i < text.size(); ++i) {
+            int d = digit(text[i]);
+            if (d < 0) {
+                run = 0;
+                code = 0;
+                continue;
+            }
+            if (run == k_) {
+                code -= digit(text[i - k_]) * high;
+            } else {
+                ++run;
+            }
+            code = code * 26 + d;
+            if (run == k_) {
+                if (isDense()) {
+                    dense_[code]++;
+                } else {
+                    incrementSparse(code);
+                }
+            }
+        }
+    }
+
+    int k() const {
+        return k_;
+    }
+
+    uint64_t encode(std::string_view gram) const {
+        uint64_t code = 0;
+        for (char c : gram) code = code * 26 + digit(c);
+        return code;
+    }
+
+    std::string decode(uint64_t code) const {
+        std::string gram(k_, first_);
+        for (int i = k_ - 1; i >= 0; --i) {
+            gram[i] = static_cast<char>(first_ + code % 26);
+            code /= 26;
+        }
+        return gram;
+    }
+
+    uint32_t count(uint64_t code) const {
+        if (isDense()) {
+            return code < size_ ? dense_[code] : 0;
+        }
+        if (sparse_.empty()) return 0;
+        size_t mask = sparse_.size() - 1;
+        for (size_t slot = slotOf(code, mask); sparse_[slot].code != 0; slot = (slot + 1) & mask) {
+            if (sparse_[slot].code == code + 1) return sparse_[slot].count;
+        }
+        return 0;
+    }
+
+    uint32_t count(std::string_view gram) const {
+        if (gram.size() != static_cast<size_t>(k_)) return 0;
+        for (char c : gram) {
+            if (digit(c) < 0) return 0;
+        }
+        return count(encode(gram));
+    }
+
+    // Calls f(code, count) for every gram that occurred
+    template <typename F>
+    void forEach(F f) const {
+        if (isDense()) {
+            for (uint64_t code = 0; code < size_; ++code) {
+                if (dense_[code] != 0) f(code, dense_[code]);
+            }
+        } else {
+            for (const NGramCount& entry : sparse_) {
+                if (entry.code != 0) f(entry.code - 1, entry.count);
+            }
+        }
+    }
+
+    // The n most frequent grams, most frequent first (ties: later gram first)
+    std::vector<NGramCount> top(size_t n) const {
+        auto better = [](const NGramCount& x, const NGramCount& y) {
+            return x.count != y.count ? x.count > y.count : x.code > y.code;
+        };
+        TopK<NGramCount, decltype(better)> best(n, better);
+        forEach([&best](uint64_t code, uint32_t count) { best.push({code, count}); });
+        return best.ranked();
+    }
+};
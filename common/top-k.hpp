@@ -0,0 +1,67 @@
+// Shared top-K extraction for the cipher tools.
+// Attacks usually print or keep only the best few of many candidates, so the
+// ranking is done with a bounded heap instead of sorting everything.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// ============================================================================
+// TopK: Keeps the k best of a stream of items
+// ============================================================================
+// Design Decision: A heap of at most k items whose root is the worst one kept.
+// An item that does not beat the root is rejected with one comparison, so a
+// pass over n items costs O(n log k) time and O(k) memory, and the items are
+// never gathered into one big container first.
+// Better(x, y) is true when x ranks ahead of y.
+
+template <typename T, typename Better = std::greater<T>>
+class TopK {
+private:
+    size_t k_;
+    Better better_;
+    std::vector<T> heap_;
+
+public:
+    explicit TopK(size_t k, Better better = Better()) : k_(k), better_(better) {}
+
+    void push(const T& item) {
+        if (k_ == 0) return;
+        if (heap_.size() < k_) {
+            heap_.push_back(item);
+            std::push_heap(heap_.begin(), heap_.end(), better_);
+        } else if (better_(item, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), better_);
+            heap_.back() = item;
+            std::push_heap(heap_.begin(), heap_.end(), better_);
+        }
+    }
+
+    size_t size() const {
+        return heap_.size();
+    }
+
+    // The kept items, best first
+    std::vector<T> ranked() const {
+        std::vector<T> result = heap_;
+        std::sort_heap(result.begin(), result.end(), better_);
+        return result;
+    }
+};
+
+// Ranked view of the k best elements of [first, last): iterators into the
+// original container, best first, without copying the elements themselves
+template <typename Iterator, typename Better>
+std::vector<Iterator> topK(Iterator first, Iterator last, size_t k, Better better) {
+    auto byElement = [&better](const Iterator& x, const Iterator& y) {
+        return better(*x, *y);
+    };
+    TopK<Iterator, decltype(byElement)> top(k, byElement);
+    for (Iterator it = first; it != last; ++it) {
+        top.push(it);
+    }
+    return top.ranked();
+}
@@ -8,45 +8,12 @@
 #include <optional>
 #include <print>
 
-constexpr int ALPHABET_SIZE = 26;
+#include "../common/modular-arithmetic.hpp"
 
-// ============================================================================
-// ModularArithmetic: Handles all modular arithmetic operations
-// ============================================================================
-// This makes the code testable and reusable
-
-class ModularArithmetic {
-public:
-    // Finds multiplicative inverse of 'a' in Z_n
-    // Returns std::nullopt if inverse doesn't exist
-    static std::optional<int> findModularInverse(int a, int modulus = ALPHABET_SIZE) {
-        // Normalize 'a' to be positive
-        a = ((a % modulus) + modulus) % modulus;
-        
-        for (int i = 1; i < modulus; ++i) {
-            if ((i * a) % modulus == 1) {
-                return i;
-            }
-        }
-        return std::nullopt;
-    }
-
-    // Performs modular subtraction ensuring positive result
-    // Design: Helper function to avoid repetitive modulo arithmetic
-    static int subtract(int a, int b, int modulus = ALPHABET_SIZE) {
-        return ((a - b) % modulus + modulus) % modulus;
-    }
-
-    // Performs modular addition
-    static int add(int a, int b, int modulus = ALPHABET_SIZE) {
-        return (a + b) % modulus;
-    }
+constexpr int ALPHABET_SIZE = 26;
 
-    // Performs modular multiplication
-    static int multiply(int a, int b, int modulus = ALPHABET_SIZE) {
-        return (a * b) % modulus;
-    }
-};
+// Table-driven arithmetic in Z_26 (see common/modular-arithmetic.hpp)
+using Z26 = Zmod<ALPHABET_SIZE>;
 
 // ============================================================================
 // LinearAlgebra: handles matric multiplication
@@ -108,7 +75,7 @@ public:
 		auto encrypted = LinearAlgebra::multiply(*key, b);
 		if (!encrypted) return std::nullopt;
 		for (auto row : *encrypted) {
-			ciphertext.push_back(ModularArithmetic::add(0, row[0]) + 'a');
+			ciphertext.push_back(Z26::reduce(row[0]) + 'a');
 		}
 		return ciphertext;
 	}
@@ -125,7 +92,7 @@ public:
 		auto encrypted = LinearAlgebra::multiply(*key, b);
 		if (!encrypted) return std::nullopt;
 		for (auto row : *encrypted) {
-			plaintext.push_back(ModularArithmetic::add(0, row[0]) + 'a');
+			plaintext.push_back(Z26::reduce(row[0]) + 'a');
 		}
 		return ciphertext;
 	}
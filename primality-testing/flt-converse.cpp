@@ -1,17 +1,29 @@
 #include <iostream>
+#include <fstream>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <algorithm>
+#include <stdexcept>
+#include <exception>
+#include <new>
 
 using namespace std;
 
-long long mod_exp(long long base, long long exp, long long mod) {
-    long long result = 1;
+uint64_t mod_exp(uint64_t base, uint64_t exp, uint64_t mod) {
+    uint64_t result = 1 % mod;
     base %= mod;
 
     while (exp > 0) {
         if (exp % 2)
-            result = (__int128)result * base % mod;
-        base = (__int128)base * base % mod;
+            result = (unsigned __int128)result * base % mod;
+        base = (unsigned __int128)base * base % mod;
         exp /= 2;
     }
     return result;
@@ -34,8 +46,209 @@ bool is_prime(long long n) {
     return true;
 }
 
-int main() {
+// spf[i] = smallest prime factor of i, for 2 <= i <= limit.
+vector<uint32_t> spf_sieve(uint32_t limit) {
+    vector<uint32_t> spf(limit + 1, 0);
+    for (uint64_t i = 2; i <= limit; ++i) {
+        if (spf[i] != 0) continue;
+        for (uint64_t j = i; j <= limit; j += i)
+            if (spf[j] == 0) spf[j] = i;
+    }
+    return spf;
+}
+
+enum class ScanMode { Carmichael, Fermat };
+
+// Largest supported end of a scan: the sieve up to sqrt(hi) then takes about 130 MB, and
+// every sum below (chunk ends, the next multiple of a prime) stays far from 2^64.
+const uint64_t MAX_HI = 1000000000000000ULL;
+
+// Finds the Carmichael numbers (Korselt: n composite, squarefree, and p-1 | n-1 for
+// every prime p | n) or the base-`base` Fermat pseudoprimes in one chunk [lo, hi).
+// Every n is factored by striking out the multiples of the primes up to sqrt(hi_total),
+// so at most one prime factor larger than that is left over.
+vector<uint64_t> scan_chunk(uint64_t lo, uint64_t hi, const vector<uint32_t>& primes,
+                            ScanMode mode, uint64_t base) {
+    size_t len = hi - lo;
+    vector<uint64_t> rest(len);
+    vector<uint8_t> factors(len, 0), squarefree(len, 1), korselt(len, 1);
+    for (size_t i = 0; i < len; ++i) rest[i] = lo + i;
+
+    for (uint64_t p : primes) {
+        uint64_t first = (lo + p - 1) / p * p;
+        for (uint64_t m = first; m < hi; m += p) {
+            size_t i = m - lo;
+            ++factors[i];
+            rest[i] /= p;
+            if (rest[i] % p == 0) squarefree[i] = 0;
+            if ((m - 1) % (p - 1) != 0) korselt[i] = 0;
+        }
+    }
+
+    vector<uint64_t> found;
+    for (size_t i = 0; i < len; ++i) {
+        uint64_t n = lo + i;
+        if (n < 4) continue;
+        if (rest[i] > 1) {
+            ++factors[i];
+            if ((n - 1) % (rest[i] - 1) != 0) korselt[i] = 0;
+        }
+        bool composite = factors[i] > 1 || !squarefree[i];
+        if (!composite) continue;
+
+        if (mode == ScanMode::Carmichael) {
+            if (squarefree[i] && korselt[i]) found.push_back(n);
+        } else if (mod_exp(base % n, n - 1, n) == 1) {
+            found.push_back(n);
+        }
+    }
+    return found;
+}
+
+// Scans [lo, hi] in parallel chunks and streams the hits to `out` in increasing order; hi <= MAX_HI.
+// Workers claim chunks from a shared counter; the calling thread writes each chunk as
+// soon as it and all earlier chunks are done. Only `window` chunks may be claimed ahead of
+// the last one written, so results live in a ring of that many slots and memory stays
+// O(threads * CHUNK) however wide the range is. Returns the number of hits.
+uint64_t scan_range(uint64_t lo, uint64_t hi, ScanMode mode, uint64_t base, ostream& out,
+                    unsigned threads = thread::hardware_concurrency()) {
+    const uint64_t CHUNK = 1 << 18;
+    if (hi < lo) return 0;
+
+    uint32_t root = (uint32_t)sqrtl((long double)hi) + 1;
+    vector<uint32_t> spf = spf_sieve(root);
+    vector<uint32_t> primes;
+    for (uint32_t i = 2; i <= root; ++i)
+        if (spf[i] == i) primes.push_back(i);
+
+    threads = max(1u, threads);
+    uint64_t chunks = (hi - lo) / CHUNK + 1;
+    const uint64_t window = 2 * (uint64_t)threads;
+    vector<vector<uint64_t>> results(window);     // chunk c lives in slot c % window
+    vector<uint8_t> done(window, 0);
+    uint64_t flushed = 0;                         // chunks written so far
+    exception_ptr failure;                        // first exception thrown by a worker
+    atomic<uint64_t> next_chunk{0};
+    mutex m;
+    condition_variable cv;
+
+    auto worker = [&]() {
+        for (uint64_t c = next_chunk++; c < chunks; c = next_chunk++) {
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [&] { return c < flushed + window || failure; });
+                if (failure) return;
+            }
+            uint64_t a = lo + c * CHUNK;
+            uint64_t b = min(hi + 1, a + CHUNK);
+            vector<uint64_t> found;
+            try {
+                found = scan_chunk(a, b, primes, mode, base);
+            } catch (...) {
+                lock_guard<mutex> lock(m);
+                if (!failure) failure = current_exception();
+                cv.notify_all();
+                return;
+            }
+            lock_guard<mutex> lock(m);
+            results[c % window] = move(found);
+            done[c % window] = 1;
+            cv.notify_all();
+        }
+    };
+
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; ++t) pool.emplace_back(worker);
+
+    uint64_t total = 0;
+    for (uint64_t c = 0; c < chunks; ++c) {
+        vector<uint64_t> found;
+        {
+            unique_lock<mutex> lock(m);
+            cv.wait(lock, [&] { return done[c % window] != 0 || failure; });
+            if (failure) break;
+            found.swap(results[c % window]);
+            done[c % window] = 0;
+            ++flushed;
+        }
+        cv.notify_all();
+        for (uint64_t n : found) out << n << "\n";
+        out.flush();
+        total += found.size();
+    }
+
+    for (auto& t : pool) t.join();
+    if (failure) rethrow_exception(failure);
+    return total;
+}
+
+int usage() {
+    cerr << "Usage: flt-converse carmichael|fermat lo hi [output-file] [base]\n"
+         << "       (0 <= lo <= hi <= " << MAX_HI << ", base >= 2)\n";
+    return 1;
+}
+
+// Usage: flt-converse carmichael|fermat lo hi [output-file] [base]
+int main(int argc, char* argv[]) {
+    if (argc >= 2) {
+        if (argc < 4 || argc > 6) return usage();
+
+        ScanMode mode;
+        if (strcmp(argv[1], "carmichael") == 0) {
+            mode = ScanMode::Carmichael;
+        } else if (strcmp(argv[1], "fermat") == 0) {
+            mode = ScanMode::Fermat;
+        } else {
+            cerr << "Unknown mode: " << argv[1] << "\n";
+            return usage();
+        }
+
+        uint64_t lo, hi, base;
+        try {
+            size_t used;
+            auto parse = [&used](const char* arg) {
+                uint64_t value = stoull(arg, &used);
+                if (arg[0] == '-' || arg[used] != '\0') throw invalid_argument(arg);
+                return value;
+            };
+            lo = parse(argv[2]);
+            hi = parse(argv[3]);
+            base = argc >= 6 ? parse(argv[5]) : 2;
+        } catch (const exception&) {
+            cerr << "Bad number\n";
+            return usage();
+        }
+        if (lo > hi || hi > MAX_HI || base < 2) return usage();
+
+        uint64_t total;
+        try {
+            if (argc >= 5) {
+                ofstream file(argv[4]);
+                if (!file) {
+                    cerr << "Cannot open " << argv[4] << "\n";
+                    return 1;
+                }
+                total = scan_range(lo, hi, mode, base, file);
+                file.close();
+                if (!file) {
+                    cerr << "Error writing " << argv[4] << "\n";
+                    return 1;
+                }
+            } else {
+                total = scan_range(lo, hi, mode, base, cout);
+            }
+        } catch (const bad_alloc&) {
+            cerr << "Out of memory scanning [" << lo << ", " << hi << "]\n";
+            return 1;
+        }
+        cerr << total << " found in [" << lo << ", " << hi << "]\n";
+        return 0;
+    }
+
     is_prime(1731);
     is_prime(1729);
     is_prime(561);
-}
\ No newline at end of file
+
+    cout << "Carmichael numbers up to 100000:\n";
+    scan_range(1, 100000, ScanMode::Carmichael, 2, cout);
+}
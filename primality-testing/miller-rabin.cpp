@@ -1,11 +1,20 @@
 #include <algorithm>
+#include <atomic>
+#include <bit>      // C++20 (std::countl_zero): build with -std=c++20
 #include <cctype>
 #include <cmath>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <random>
+#include <span>     // C++20
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 class ModularArithmetic {
@@ -25,76 +34,211 @@ public:
 
 class Number {
 private:
-    // Decimal digits in little-endian order: 123 is stored as {3, 2, 1}.
-    std::vector<int> digits;
+    friend class Montgomery;
+
+    using Limb = std::uint64_t;
+    using DoubleLimb = unsigned __int128;
+
+    // Largest power of ten that fits in one limb, used for decimal conversion.
+    static constexpr Limb DECIMAL_CHUNK = 10000000000000000000ULL;
+    static constexpr int DECIMAL_CHUNK_DIGITS = 19;
+
+    // Operand sizes (in limbs) at which Karatsuba overtakes the schoolbook kernels.
+    static constexpr std::size_t KARATSUBA_THRESHOLD = 32;
+    static constexpr std::size_t KARATSUBA_SQUARE_THRESHOLD = 48;
+
+    // Binary limbs in little-endian order: limbs[0] holds the lowest 64 bits.
+    std::vector<Limb> limbs;
 
     void trim() {
-        while (digits.size() > 1 && digits.back() == 0) {
-            digits.pop_back();
+        while (limbs.size() > 1 && limbs.back() == 0) {
+            limbs.pop_back();
         }
     }
 
     static int compare(const Number& a, const Number& b) {
-        if (a.digits.size() != b.digits.size()) {
-            return (a.digits.size() < b.digits.size()) ? -1 : 1;
+        if (a.limbs.size() != b.limbs.size()) {
+            return (a.limbs.size() < b.limbs.size()) ? -1 : 1;
         }
 
-        for (int i = static_cast<int>(a.digits.size()) - 1; i >= 0; --i) {
-            if (a.digits[i] != b.digits[i]) {
-                return (a.digits[i] < b.digits[i]) ? -1 : 1;
+        for (int i = static_cast<int>(a.limbs.size()) - 1; i >= 0; --i) {
+            if (a.limbs[i] != b.limbs[i]) {
+                return (a.limbs[i] < b.limbs[i]) ? -1 : 1;
             }
         }
         return 0;
     }
 
-    void multiplyBy10() {
-        if (isZero()) {
-            return;
+    // this = this * factor + addend
+    void multiplyAddSmall(Limb factor, Limb addend) {
+        Limb carry = addend;
+        for (Limb& limb : limbs) {
+            DoubleLimb cur = static_cast<DoubleLimb>(limb) * factor + carry;
+            limb = static_cast<Limb>(cur);
+            carry = static_cast<Limb>(cur >> 64);
+        }
+        if (carry > 0) {
+            limbs.push_back(carry);
         }
-        digits.insert(digits.begin(), 0);
+        trim();
     }
 
-    void addSmall(int value) {
-        if (value < 0 || value > 9) {
-            throw std::invalid_argument("addSmall expects a digit in [0, 9]");
+    // this = this / divisor, returns this % divisor
+    Limb divideSmall(Limb divisor) {
+        DoubleLimb remainder = 0;
+        for (int i = static_cast<int>(limbs.size()) - 1; i >= 0; --i) {
+            DoubleLimb cur = (remainder << 64) | limbs[i];
+            limbs[i] = static_cast<Limb>(cur / divisor);
+            remainder = cur % divisor;
         }
+        trim();
+        return static_cast<Limb>(remainder);
+    }
 
-        int carry = value;
+    // dst[0..n) += src[0..m) with m <= n, returns the carry out of dst[n - 1].
+    static Limb addLimbs(Limb* dst, std::size_t n, const Limb* src, std::size_t m) {
+        Limb carry = 0;
         std::size_t i = 0;
-        while (carry > 0) {
-            if (i == digits.size()) {
-                digits.push_back(0);
+        for (; i < m; ++i) {
+            DoubleLimb sum = static_cast<DoubleLimb>(dst[i]) + src[i] + carry;
+            dst[i] = static_cast<Limb>(sum);
+            carry = static_cast<Limb>(sum >> 64);
+        }
+        for (; carry > 0 && i < n; ++i) {
+            carry = (++dst[i] == 0) ? 1 : 0;
+        }
+        return carry;
+    }
+
+    // dst[0..n) -= src[0..m) with m <= n, the caller guarantees dst >= src.
+    static void subtractLimbs(Limb* dst, std::size_t n, const Limb* src, std::size_t m) {
+        Limb borrow = 0;
+        std::size_t i = 0;
+        for (; i < m; ++i) {
+            DoubleLimb diff = static_cast<DoubleLimb>(dst[i]) - src[i] - borrow;
+            dst[i] = static_cast<Limb>(diff);
+            borrow = static_cast<Limb>(diff >> 64) ? 1 : 0;
+        }
+        for (; borrow > 0 && i < n; ++i) {
+            borrow = (dst[i]-- == 0) ? 1 : 0;
+        }
+    }
+
+    // out[0..na+nb) = a * b
+    static void multiplySchoolbook(const Limb* a, std::size_t na, const Limb* b, std::size_t nb, Limb* out) {
+        std::fill(out, out + na + nb, 0);
+        for (std::size_t i = 0; i < na; ++i) {
+            Limb carry = 0;
+            for (std::size_t j = 0; j < nb; ++j) {
+                DoubleLimb cur = static_cast<DoubleLimb>(a[i]) * b[j] + out[i + j] + carry;
+                out[i + j] = static_cast<Limb>(cur);
+                carry = static_cast<Limb>(cur >> 64);
             }
-            int sum = digits[i] + carry;
-            digits[i] = sum % 10;
-            carry = sum / 10;
-            ++i;
+            out[i + nb] = carry;
         }
     }
 
-    static Number multiplyByDigit(const Number& n, int digit) {
-        if (digit < 0 || digit > 9) {
-            throw std::invalid_argument("multiplyByDigit expects a digit in [0, 9]");
+    // out[0..2n) = a^2, computing each cross product a[i]*a[j] (i < j) once and doubling.
+    static void squareSchoolbook(const Limb* a, std::size_t n, Limb* out) {
+        std::fill(out, out + 2 * n, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            Limb carry = 0;
+            for (std::size_t j = i + 1; j < n; ++j) {
+                DoubleLimb cur = static_cast<DoubleLimb>(a[i]) * a[j] + out[i + j] + carry;
+                out[i + j] = static_cast<Limb>(cur);
+                carry = static_cast<Limb>(cur >> 64);
+            }
+            out[i + n] = carry;
         }
-        if (digit == 0 || n.isZero()) {
-            return Number(0);
+
+        Limb shiftCarry = 0;
+        for (std::size_t i = 0; i < 2 * n; ++i) {
+            Limb next = out[i] >> 63;
+            out[i] = (out[i] << 1) | shiftCarry;
+            shiftCarry = next;
         }
 
-        Number result;
-        result.digits.assign(n.digits.size() + 1, 0);
-        int carry = 0;
-        for (std::size_t i = 0; i < n.digits.size(); ++i) {
-            int prod = n.digits[i] * digit + carry;
-            result.digits[i] = prod % 10;
-            carry = prod / 10;
+        Limb carry = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            DoubleLimb diagonal = static_cast<DoubleLimb>(a[i]) * a[i];
+            DoubleLimb low = static_cast<DoubleLimb>(out[2 * i]) + static_cast<Limb>(diagonal) + carry;
+            out[2 * i] = static_cast<Limb>(low);
+            DoubleLimb high = static_cast<DoubleLimb>(out[2 * i + 1]) + static_cast<Limb>(diagonal >> 64) + (low >> 64);
+            out[2 * i + 1] = static_cast<Limb>(high);
+            carry = static_cast<Limb>(high >> 64);
         }
-        if (carry > 0) {
-            result.digits[n.digits.size()] = carry;
+    }
+
+    // out[0..na+nb) = a * b, dispatching on operand size.
+    static void multiplyLimbs(const Limb* a, std::size_t na, const Limb* b, std::size_t nb, Limb* out) {
+        if (na < nb) {
+            std::swap(a, b);
+            std::swap(na, nb);
         }
-        result.trim();
-        return result;
+        if (nb < KARATSUBA_THRESHOLD) {
+            multiplySchoolbook(a, na, b, nb, out);
+            return;
+        }
+
+        std::size_t h = (na + 1) / 2;
+        if (nb <= h) {
+            // Unbalanced operands: multiply b by nb-limb slices of a.
+            std::fill(out, out + na + nb, 0);
+            std::vector<Limb> partial(2 * nb);
+            for (std::size_t offset = 0; offset < na; offset += nb) {
+                std::size_t len = std::min(nb, na - offset);
+                multiplyLimbs(a + offset, len, b, nb, partial.data());
+                addLimbs(out + offset, na + nb - offset, partial.data(), len + nb);
+            }
+            return;
+        }
+
+        // Karatsuba: a*b = z2*B^2h + z1*B^h + z0 with z1 = (a0+a1)(b0+b1) - z0 - z2.
+        std::size_t na1 = na - h;
+        std::size_t nb1 = nb - h;
+        multiplyLimbs(a, h, b, h, out);
+        multiplyLimbs(a + h, na1, b + h, nb1, out + 2 * h);
+
+        std::vector<Limb> sumA(a, a + h);
+        std::vector<Limb> sumB(b, b + h);
+        sumA.push_back(addLimbs(sumA.data(), h, a + h, na1));
+        sumB.push_back(addLimbs(sumB.data(), h, b + h, nb1));
+
+        std::vector<Limb> middle(2 * h + 2);
+        multiplyLimbs(sumA.data(), h + 1, sumB.data(), h + 1, middle.data());
+        subtractLimbs(middle.data(), middle.size(), out, 2 * h);
+        subtractLimbs(middle.data(), middle.size(), out + 2 * h, na1 + nb1);
+
+        std::size_t middleLength = std::min(middle.size(), na + nb - h);
+        addLimbs(out + h, na + nb - h, middle.data(), middleLength);
+    }
+
+    // out[0..2n) = a^2, dispatching on operand size.
+    static void squareLimbs(const Limb* a, std::size_t n, Limb* out) {
+        if (n < KARATSUBA_SQUARE_THRESHOLD) {
+            squareSchoolbook(a, n, out);
+            return;
+        }
+
+        // Karatsuba squaring: z1 = (a0+a1)^2 - z0 - z2, with all three products squares.
+        std::size_t h = (n + 1) / 2;
+        std::size_t n1 = n - h;
+        squareLimbs(a, h, out);
+        squareLimbs(a + h, n1, out + 2 * h);
+
+        std::vector<Limb> sum(a, a + h);
+        sum.push_back(addLimbs(sum.data(), h, a + h, n1));
+
+        std::vector<Limb> middle(2 * h + 2);
+        squareLimbs(sum.data(), h + 1, middle.data());
+        subtractLimbs(middle.data(), middle.size(), out, 2 * h);
+        subtractLimbs(middle.data(), middle.size(), out + 2 * h, 2 * n1);
+
+        std::size_t middleLength = std::min(middle.size(), 2 * n - h);
+        addLimbs(out + h, 2 * n - h, middle.data(), middleLength);
     }
 
+    // Knuth, TAOCP Vol. 2, 4.3.1, Algorithm D with 64-bit limbs.
     static std::pair<Number, Number> divmod(const Number& dividend, const Number& divisor) {
         if (divisor.isZero()) {
             throw std::invalid_argument("division by zero");
@@ -102,67 +246,97 @@ private:
         if (dividend < divisor) {
             return {Number(0), dividend};
         }
+        if (divisor.limbs.size() == 1) {
+            Number quotient = dividend;
+            Limb remainder = quotient.divideSmall(divisor.limbs[0]);
+            return {quotient, Number(remainder)};
+        }
 
-        Number remainder(0);
-        std::vector<int> quotientMsdFirst;
-        quotientMsdFirst.reserve(dividend.digits.size());
+        const std::size_t n = divisor.limbs.size();
+        const std::size_t m = dividend.limbs.size() - n;
+        const int shift = std::countl_zero(divisor.limbs.back());
+
+        // Normalize so the top limb of the divisor has its high bit set.
+        std::vector<Limb> v(n);
+        std::vector<Limb> u(dividend.limbs.size() + 1);
+        for (std::size_t i = n; i-- > 0;) {
+            v[i] = divisor.limbs[i] << shift;
+            if (shift > 0 && i > 0) {
+                v[i] |= divisor.limbs[i - 1] >> (64 - shift);
+            }
+        }
+        u[dividend.limbs.size()] = (shift > 0) ? dividend.limbs.back() >> (64 - shift) : 0;
+        for (std::size_t i = dividend.limbs.size(); i-- > 0;) {
+            u[i] = dividend.limbs[i] << shift;
+            if (shift > 0 && i > 0) {
+                u[i] |= dividend.limbs[i - 1] >> (64 - shift);
+            }
+        }
 
-        for (int i = static_cast<int>(dividend.digits.size()) - 1; i >= 0; --i) {
-            remainder.multiplyBy10();
-            remainder.addSmall(dividend.digits[i]);
+        Number quotient;
+        quotient.limbs.assign(m + 1, 0);
 
-            int low = 0;
-            int high = 9;
-            int qDigit = 0;
+        for (std::size_t j = m + 1; j-- > 0;) {
+            DoubleLimb numerator = (static_cast<DoubleLimb>(u[j + n]) << 64) | u[j + n - 1];
+            DoubleLimb qHat = numerator / v[n - 1];
+            DoubleLimb rHat = numerator % v[n - 1];
 
-            while (low <= high) {
-                int mid = (low + high) / 2;
-                Number guess = multiplyByDigit(divisor, mid);
-                if (guess <= remainder) {
-                    qDigit = mid;
-                    low = mid + 1;
-                } else {
-                    high = mid - 1;
+            while ((qHat >> 64) != 0 || qHat * v[n - 2] > ((rHat << 64) | u[j + n - 2])) {
+                --qHat;
+                rHat += v[n - 1];
+                if ((rHat >> 64) != 0) {
+                    break;
                 }
             }
 
-            quotientMsdFirst.push_back(qDigit);
-            if (qDigit > 0) {
-                remainder = remainder - multiplyByDigit(divisor, qDigit);
+            // u[j .. j+n] -= qHat * v
+            Limb borrow = 0;
+            Limb carry = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                DoubleLimb product = qHat * v[i] + carry;
+                carry = static_cast<Limb>(product >> 64);
+                DoubleLimb diff = static_cast<DoubleLimb>(u[i + j]) - static_cast<Limb>(product) - borrow;
+                u[i + j] = static_cast<Limb>(diff);
+                borrow = static_cast<Limb>(diff >> 64) ? 1 : 0;
+            }
+            DoubleLimb diff = static_cast<DoubleLimb>(u[j + n]) - carry - borrow;
+            u[j + n] = static_cast<Limb>(diff);
+
+            // qHat was one too large: add the divisor back.
+            if ((diff >> 64) != 0) {
+                --qHat;
+                Limb addCarry = 0;
+                for (std::size_t i = 0; i < n; ++i) {
+                    DoubleLimb sum = static_cast<DoubleLimb>(u[i + j]) + v[i] + addCarry;
+                    u[i + j] = static_cast<Limb>(sum);
+                    addCarry = static_cast<Limb>(sum >> 64);
+                }
+                u[j + n] += addCarry;
             }
-        }
 
-        Number quotient;
-        quotient.digits.clear();
-        int firstNonZero = 0;
-        while (firstNonZero < static_cast<int>(quotientMsdFirst.size()) - 1 && quotientMsdFirst[firstNonZero] == 0) {
-            ++firstNonZero;
+            quotient.limbs[j] = static_cast<Limb>(qHat);
         }
-        for (int i = static_cast<int>(quotientMsdFirst.size()) - 1; i >= firstNonZero; --i) {
-            quotient.digits.push_back(quotientMsdFirst[i]);
+
+        Number remainder;
+        remainder.limbs.assign(n, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            remainder.limbs[i] = u[i] >> shift;
+            if (shift > 0) {
+                remainder.limbs[i] |= u[i + 1] << (64 - shift);
+            }
         }
+
         quotient.trim();
         remainder.trim();
-
         return {quotient, remainder};
     }
 
 public:
-    Number() : digits(1, 0) {}
+    Number() : limbs(1, 0) {}
 
-    Number(unsigned long long value) {
-        if (value == 0) {
-            digits = {0};
-            return;
-        }
+    Number(unsigned long long value) : limbs(1, value) {}
 
-        while (value > 0) {
-            digits.push_back(static_cast<int>(value % 10ULL));
-            value /= 10ULL;
-        }
-    }
-
-    explicit Number(const std::string& numStr) {
+    explicit Number(const std::string& numStr) : limbs(1, 0) {
         if (numStr.empty()) {
             throw std::invalid_argument("number string cannot be empty");
         }
@@ -173,15 +347,23 @@ public:
             }
         }
 
-        int i = 0;
-        while (i < static_cast<int>(numStr.size()) - 1 && numStr[i] == '0') {
-            ++i;
+        // Consume the decimal string in 19-digit chunks, most significant first.
+        std::size_t pos = 0;
+        std::size_t headLength = numStr.size() % DECIMAL_CHUNK_DIGITS;
+        if (headLength == 0) {
+            headLength = DECIMAL_CHUNK_DIGITS;
         }
-
-        for (int j = static_cast<int>(numStr.size()) - 1; j >= i; --j) {
-            digits.push_back(numStr[j] - '0');
+        while (pos < numStr.size()) {
+            std::size_t chunkLength = (pos == 0) ? headLength : DECIMAL_CHUNK_DIGITS;
+            Limb chunk = 0;
+            Limb scale = 1;
+            for (std::size_t i = 0; i < chunkLength; ++i) {
+                chunk = chunk * 10 + static_cast<Limb>(numStr[pos + i] - '0');
+                scale *= 10;
+            }
+            multiplyAddSmall(scale, chunk);
+            pos += chunkLength;
         }
-        trim();
     }
 
     static Number rand(const std::string& scale) {
@@ -216,21 +398,66 @@ public:
         }
     }
 
+    static Number powerOfTwo(std::size_t exponent) {
+        Number result;
+        result.limbs.assign(exponent / 64 + 1, 0);
+        result.limbs.back() = Limb{1} << (exponent % 64);
+        return result;
+    }
+
+    // Uniform value in [0, 2^bits).
+    static Number randomBits(std::size_t bits, std::mt19937_64& rng) {
+        if (bits == 0) {
+            return Number(0);
+        }
+
+        Number result;
+        result.limbs.resize((bits + 63) / 64);
+        for (Limb& limb : result.limbs) {
+            limb = rng();
+        }
+        if (bits % 64 != 0) {
+            result.limbs.back() &= (Limb{1} << (bits % 64)) - 1;
+        }
+        result.trim();
+        return result;
+    }
+
     std::string toString() const {
-        std::string result;
-        result.reserve(digits.size());
-        for (int i = static_cast<int>(digits.size()) - 1; i >= 0; --i) {
-            result.push_back(static_cast<char>('0' + digits[i]));
+        if (isZero()) {
+            return "0";
+        }
+
+        // Peel off 19-digit chunks, least significant first.
+        Number rest = *this;
+        std::vector<Limb> chunks;
+        while (!rest.isZero()) {
+            chunks.push_back(rest.divideSmall(DECIMAL_CHUNK));
+        }
+
+        std::string result = std::to_string(chunks.back());
+        result.reserve(chunks.size() * DECIMAL_CHUNK_DIGITS);
+        for (int i = static_cast<int>(chunks.size()) - 2; i >= 0; --i) {
+            std::string chunk = std::to_string(chunks[i]);
+            result.append(DECIMAL_CHUNK_DIGITS - chunk.size(), '0');
+            result += chunk;
         }
         return result;
     }
 
     bool isZero() const {
-        return digits.size() == 1 && digits[0] == 0;
+        return limbs.size() == 1 && limbs[0] == 0;
+    }
+
+    std::optional<std::uint64_t> toUint64() const {
+        if (limbs.size() > 1) {
+            return std::nullopt;
+        }
+        return limbs[0];
     }
 
     bool isEven() const {
-        return (digits[0] % 2) == 0;
+        return (limbs[0] & 1) == 0;
     }
 
     int modSmall(int m) const {
@@ -238,22 +465,34 @@ public:
             throw std::invalid_argument("modulus must be positive");
         }
 
-        int remainder = 0;
-        for (int i = static_cast<int>(digits.size()) - 1; i >= 0; --i) {
-            remainder = (remainder * 10 + digits[i]) % m;
+        DoubleLimb remainder = 0;
+        for (int i = static_cast<int>(limbs.size()) - 1; i >= 0; --i) {
+            remainder = ((remainder << 64) | limbs[i]) % static_cast<Limb>(m);
         }
-        return remainder;
+        return static_cast<int>(remainder);
+    }
+
+    std::size_t bitLength() const {
+        if (isZero()) {
+            return 0;
+        }
+        return 64 * limbs.size() - std::countl_zero(limbs.back());
+    }
+
+    bool testBit(std::size_t index) const {
+        std::size_t limb = index / 64;
+        return limb < limbs.size() && ((limbs[limb] >> (index % 64)) & 1) != 0;
     }
 
     Number half() const {
         Number result;
-        result.digits.assign(digits.size(), 0);
+        result.limbs.assign(limbs.size(), 0);
 
-        int carry = 0;
-        for (int i = static_cast<int>(digits.size()) - 1; i >= 0; --i) {
-            int cur = carry * 10 + digits[i];
-            result.digits[i] = cur / 2;
-            carry = cur % 2;
+        for (std::size_t i = 0; i < limbs.size(); ++i) {
+            result.limbs[i] = limbs[i] >> 1;
+            if (i + 1 < limbs.size()) {
+                result.limbs[i] |= limbs[i + 1] << 63;
+            }
         }
         result.trim();
         return result;
@@ -285,15 +524,15 @@ public:
 
     Number operator+(const Number& other) const {
         Number result;
-        result.digits.assign(std::max(digits.size(), other.digits.size()) + 1, 0);
-
-        int carry = 0;
-        for (std::size_t i = 0; i < result.digits.size(); ++i) {
-            int a = (i < digits.size()) ? digits[i] : 0;
-            int b = (i < other.digits.size()) ? other.digits[i] : 0;
-            int sum = a + b + carry;
-            result.digits[i] = sum % 10;
-            carry = sum / 10;
+        result.limbs.assign(std::max(limbs.size(), other.limbs.size()) + 1, 0);
+
+        Limb carry = 0;
+        for (std::size_t i = 0; i < result.limbs.size(); ++i) {
+            Limb a = (i < limbs.size()) ? limbs[i] : 0;
+            Limb b = (i < other.limbs.size()) ? other.limbs[i] : 0;
+            DoubleLimb sum = static_cast<DoubleLimb>(a) + b + carry;
+            result.limbs[i] = static_cast<Limb>(sum);
+            carry = static_cast<Limb>(sum >> 64);
         }
         result.trim();
         return result;
@@ -305,19 +544,14 @@ public:
         }
 
         Number result;
-        result.digits.assign(digits.size(), 0);
-
-        int borrow = 0;
-        for (std::size_t i = 0; i < digits.size(); ++i) {
-            int a = digits[i] - borrow;
-            int b = (i < other.digits.size()) ? other.digits[i] : 0;
-            if (a < b) {
-                a += 10;
-                borrow = 1;
-            } else {
-                borrow = 0;
-            }
-            result.digits[i] = a - b;
+        result.limbs.assign(limbs.size(), 0);
+
+        Limb borrow = 0;
+        for (std::size_t i = 0; i < limbs.size(); ++i) {
+            Limb b = (i < other.limbs.size()) ? other.limbs[i] : 0;
+            DoubleLimb diff = static_cast<DoubleLimb>(limbs[i]) - b - borrow;
+            result.limbs[i] = static_cast<Limb>(diff);
+            borrow = static_cast<Limb>(diff >> 64) ? 1 : 0;
         }
         result.trim();
         return result;
@@ -327,30 +561,25 @@ public:
         if (isZero() || other.isZero()) {
             return Number(0);
         }
+        if (this == &other) {
+            return squared();
+        }
 
         Number result;
-        result.digits.assign(digits.size() + other.digits.size(), 0);
-
-        for (std::size_t i = 0; i < digits.size(); ++i) {
-            int carry = 0;
-            for (std::size_t j = 0; j < other.digits.size(); ++j) {
-                int idx = static_cast<int>(i + j);
-                int val = result.digits[idx] + digits[i] * other.digits[j] + carry;
-                result.digits[idx] = val % 10;
-                carry = val / 10;
-            }
-
-            std::size_t idx = i + other.digits.size();
-            while (carry > 0) {
-                int val = result.digits[idx] + carry;
-                result.digits[idx] = val % 10;
-                carry = val / 10;
-                ++idx;
-                if (idx == result.digits.size() && carry > 0) {
-                    result.digits.push_back(0);
-                }
-            }
+        result.limbs.resize(limbs.size() + other.limbs.size());
+        multiplyLimbs(limbs.data(), limbs.size(), other.limbs.data(), other.limbs.size(), result.limbs.data());
+        result.trim();
+        return result;
+    }
+
+    Number squared() const {
+        if (isZero()) {
+            return Number(0);
         }
+
+        Number result;
+        result.limbs.resize(2 * limbs.size());
+        squareLimbs(limbs.data(), limbs.size(), result.limbs.data());
         result.trim();
         return result;
     }
@@ -364,32 +593,662 @@ public:
     }
 };
 
+// Montgomery arithmetic modulo an odd n with R = 2^(64k), where k is the limb count of n.
+// A residue x is kept in Montgomery form as x*R mod n, so each modular product needs
+// one REDC pass instead of a long division.
+class Montgomery {
+private:
+    using Limb = Number::Limb;
+    using DoubleLimb = Number::DoubleLimb;
+
+    Number modulus;
+    std::size_t size;   // k, the limb count of the modulus
+    Limb nPrime;        // -n^-1 mod 2^64
+    Number rModN;       // R mod n, which is 1 in Montgomery form
+    Number r2ModN;      // R^2 mod n, used to enter Montgomery form
+    Number minusOneForm;
+
+    // Montgomery reduction (SOS): returns t * R^-1 mod n for t < n*R.
+    Number redc(const Number& t) const {
+        std::vector<Limb> work(2 * size + 1, 0);
+        std::copy(t.limbs.begin(), t.limbs.end(), work.begin());
+
+        for (std::size_t i = 0; i < size; ++i) {
+            Limb m = work[i] * nPrime;
+            Limb carry = 0;
+            for (std::size_t j = 0; j < size; ++j) {
+                DoubleLimb cur = static_cast<DoubleLimb>(m) * modulus.limbs[j] + work[i + j] + carry;
+                work[i + j] = static_cast<Limb>(cur);
+                carry = static_cast<Limb>(cur >> 64);
+            }
+            for (std::size_t j = i + size; carry > 0; ++j) {
+                DoubleLimb cur = static_cast<DoubleLimb>(work[j]) + carry;
+                work[j] = static_cast<Limb>(cur);
+                carry = static_cast<Limb>(cur >> 64);
+            }
+        }
+
+        Number result;
+        result.limbs.assign(work.begin() + size, work.end());
+        result.trim();
+        if (result >= modulus) {
+            result = result - modulus;
+        }
+        return result;
+    }
+
+public:
+    explicit Montgomery(const Number& n) : modulus(n), size(n.limbs.size()) {
+        if (n.isEven() || n < Number(3)) {
+            throw std::invalid_argument("Montgomery modulus must be odd and >= 3");
+        }
+
+        // Newton iteration doubles the correct low bits each step: 3 -> 6 -> ... -> 96.
+        Limb inverse = n.limbs[0];
+        for (int i = 0; i < 5; ++i) {
+            inverse *= 2 - n.limbs[0] * inverse;
+        }
+        nPrime = ~inverse + 1;
+
+        Number r;
+        r.limbs.assign(size + 1, 0);
+        r.limbs[size] = 1;
+        rModN = r % modulus;
+        r2ModN = rModN.squared() % modulus;
+        minusOneForm = modulus - rModN;
+    }
+
+    const Number& getModulus() const {
+        return modulus;
+    }
+
+    // Montgomery forms of +1 and -1.
+    const Number& one() const {
+        return rModN;
+    }
+
+    const Number& minusOne() const {
+        return minusOneForm;
+    }
+
+    // Additive operations are the same on Montgomery forms as on plain residues.
+    Number add(const Number& a, const Number& b) const {
+        Number sum = a + b;
+        return (sum >= modulus) ? sum - modulus : sum;
+    }
+
+    Number subtract(const Number& a, const Number& b) const {
+        return (a >= b) ? a - b : a + modulus - b;
+    }
+
+    // a / 2 mod n, valid since n is odd.
+    Number halve(const Number& a) const {
+        return a.isEven() ? a.half() : (a + modulus).half();
+    }
+
+    Number toMontgomery(const Number& x) const {
+        return multiply(x % modulus, r2ModN);
+    }
+
+    Number fromMontgomery(const Number& x) const {
+        return redc(x);
+    }
+
+    // Both operands must already be in Montgomery form.
+    Number multiply(const Number& a, const Number& b) const {
+        return redc(a * b);
+    }
+
+    Number square(const Number& a) const {
+        return redc(a.squared());
+    }
+};
+
+// Thread pool for one batch of independent tasks. Every worker drains its own deque
+// from the back and, once that is empty, steals from the front of the other deques.
+// Tasks never spawn tasks, so a worker that finds every deque empty is done.
+class WorkStealingPool {
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    unsigned threadCount;
+
+public:
+    explicit WorkStealingPool(unsigned threads) : threadCount(std::max(1u, threads)) {}
+
+    // Runs task(i) for every i in [0, taskCount). Worker w starts with the w-th
+    // contiguous block, so neighbouring tasks tend to stay on the same thread.
+    template <typename Task>
+    void run(std::size_t taskCount, const Task& task) {
+        unsigned workers = static_cast<unsigned>(std::min<std::size_t>(threadCount, std::max<std::size_t>(taskCount, 1)));
+        std::vector<TaskQueue> queues(workers);
+        for (unsigned w = 0; w < workers; ++w) {
+            std::size_t begin = taskCount * w / workers;
+            std::size_t end = taskCount * (w + 1) / workers;
+            for (std::size_t i = end; i-- > begin;) {
+                queues[w].tasks.push_back(i);
+            }
+        }
+
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        auto worker = [&](unsigned self) {
+            while (true) {
+                std::size_t index = 0;
+                bool found = false;
+                for (unsigned k = 0; k < workers && !found; ++k) {
+                    TaskQueue& queue = queues[(self + k) % workers];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    if (!queue.tasks.empty()) {
+                        if (k == 0) {
+                            index = queue.tasks.back();
+                            queue.tasks.pop_back();
+                        } else {
+                            index = queue.tasks.front();
+                            queue.tasks.pop_front();
+                        }
+                        found = true;
+                    }
+                }
+                if (!found) {
+                    return;
+                }
+
+                try {
+                    task(index);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (unsigned w = 1; w < workers; ++w) {
+            threads.emplace_back(worker, w);
+        }
+        worker(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+// Deterministic Miller-Rabin for n < 2^64 on machine words with 64-bit Montgomery
+// multiplication. The base set below is known to classify every 64-bit input
+// correctly, so there is no RNG and no error bound.
+class MillerRabin64 {
+private:
+    static constexpr std::uint64_t BASES[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+    struct Montgomery64 {
+        std::uint64_t n;
+        std::uint64_t nInverse;   // n^-1 mod 2^64
+        std::uint64_t one;        // 2^64 mod n
+        std::uint64_t r2;         // 2^128 mod n
+
+        explicit Montgomery64(std::uint64_t modulus) : n(modulus) {
+            nInverse = n;
+            for (int i = 0; i < 5; ++i) {
+                nInverse *= 2 - n * nInverse;
+            }
+            one = (0 - n) % n;
+            r2 = static_cast<std::uint64_t>(static_cast<unsigned __int128>(one) * one % n);
+        }
+
+        // t * 2^-64 mod n, written so that t + m*n never needs 129 bits.
+        std::uint64_t redc(unsigned __int128 t) const {
+            std::uint64_t m = static_cast<std::uint64_t>(t) * nInverse;
+            std::uint64_t mnHigh = static_cast<std::uint64_t>((static_cast<unsigned __int128>(m) * n) >> 64);
+            std::uint64_t tHigh = static_cast<std::uint64_t>(t >> 64);
+            return (tHigh >= mnHigh) ? tHigh - mnHigh : tHigh - mnHigh + n;
+        }
+
+        std::uint64_t multiply(std::uint64_t a, std::uint64_t b) const {
+            return redc(static_cast<unsigned __int128>(a) * b);
+        }
+
+        std::uint64_t toMontgomery(std::uint64_t a) const {
+            return multiply(a % n, r2);
+        }
+    };
+
+public:
+    static bool isPrime(std::uint64_t n) {
+        if (n < 2) {
+            return false;
+        }
+        for (std::uint64_t p : {2ULL, 3ULL, 5ULL, 7ULL, 11ULL, 13ULL, 17ULL, 19ULL, 23ULL, 29ULL, 31ULL, 37ULL}) {
+            if (n % p == 0) {
+                return n == p;
+            }
+        }
+
+        std::uint64_t d = n - 1;
+        int s = std::countr_zero(d);
+        d >>= s;
+
+        Montgomery64 ctx(n);
+        std::uint64_t minusOne = n - ctx.one;
+
+        for (std::uint64_t base : BASES) {
+            std::uint64_t a = base % n;
+            if (a == 0) {
+                continue;
+            }
+
+            std::uint64_t power = ctx.toMontgomery(a);
+            std::uint64_t x = ctx.one;
+            for (std::uint64_t e = d; e > 0; e >>= 1) {
+                if (e & 1) {
+                    x = ctx.multiply(x, power);
+                }
+                power = ctx.multiply(power, power);
+            }
+
+            if (x == ctx.one || x == minusOne) {
+                continue;
+            }
+
+            bool reachedMinusOne = false;
+            for (int r = 1; r < s && !reachedMinusOne; ++r) {
+                x = ctx.multiply(x, x);
+                reachedMinusOne = (x == minusOne);
+            }
+            if (!reachedMinusOne) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Trace policies for MillerRabin, passed as a template parameter. With SilentTrace
+// every report statement sits in a discarded `if constexpr` branch, so the hot path
+// does no I/O and builds no decimal strings. ReportTrace writes the full
+// textbook transcript to its sink.
+struct SilentTrace {
+    static constexpr bool enabled = false;
+};
+
+struct ReportTrace {
+    static constexpr bool enabled = true;
+    std::ostream* sink = &std::cout;
+
+    std::ostream& out() const {
+        return *sink;
+    }
+};
+
+// Incremental sieve for prime search. The residues of the start value modulo the
+// first few thousand odd primes are computed once; stepping to the next odd candidate
+// then costs one add-and-compare per prime, and only candidates without a small
+// factor are handed out.
+class PrimeSieve {
+private:
+    std::vector<std::uint32_t> primes;
+    std::vector<std::uint32_t> residues;
+    Number start;
+    std::uint64_t offset = 0;
+    std::optional<std::uint64_t> smallStart;   // set while candidates may equal a sieve prime
+
+    static std::vector<std::uint32_t> oddPrimes(std::size_t count) {
+        std::size_t limit = 64;
+        while (true) {
+            std::vector<bool> composite(limit + 1, false);
+            std::vector<std::uint32_t> found;
+            for (std::size_t i = 3; i <= limit && found.size() < count; i += 2) {
+                if (composite[i]) {
+                    continue;
+                }
+                found.push_back(static_cast<std::uint32_t>(i));
+                for (std::size_t j = i * i; j <= limit; j += 2 * i) {
+                    composite[j] = true;
+                }
+            }
+            if (found.size() == count) {
+                return found;
+            }
+            limit *= 2;
+        }
+    }
+
+    bool survives() const {
+        for (std::size_t i = 0; i < primes.size(); ++i) {
+            if (residues[i] == 0 && (!smallStart || *smallStart + offset != primes[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void advance() {
+        offset += 2;
+        for (std::size_t i = 0; i < primes.size(); ++i) {
+            std::uint32_t r = residues[i] + 2;
+            residues[i] = (r >= primes[i]) ? r - primes[i] : r;
+        }
+    }
+
+public:
+    // `from` is rounded up to the next odd number.
+    explicit PrimeSieve(const Number& from, std::size_t primeCount = 2048)
+        : primes(oddPrimes(primeCount)), start(from.isEven() ? from + Number(1) : from) {
+        residues.reserve(primes.size());
+        for (std::uint32_t p : primes) {
+            residues.push_back(static_cast<std::uint32_t>(start.modSmall(static_cast<int>(p))));
+        }
+        smallStart = start.toUint64();
+    }
+
+    // Next odd candidate (starting with the current one) free of sieve-prime factors.
+    Number next() {
+        while (!survives()) {
+            advance();
+        }
+        Number candidate = start + Number(offset);
+        advance();
+        return candidate;
+    }
+};
+
 class MillerRabin {
 private:
-    static std::string residueLabel(const Number& x, const Number& nMinusOne) {
-        if (x == Number(1)) {
+    static constexpr int SMALL_PRIMES[] = {
+        2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37,
+        41, 43, 47, 53, 59, 61, 67, 71, 73, 79, 83, 89, 97
+    };
+
+    // Per-candidate state shared by the round tasks of isProbablePrimeBatch.
+    struct BatchCandidate {
+        std::once_flag prepared;
+        std::atomic<bool> settled{false};
+        std::atomic<bool> composite{false};
+        std::optional<Montgomery> ctx;
+        Number d;
+        int s = 0;
+    };
+
+    // Small-prime screening and n - 1 = 2^s * d decomposition, run once per candidate.
+    static void prepareCandidate(const Number& n, BatchCandidate& state) {
+        if (std::optional<std::uint64_t> word = n.toUint64()) {
+            state.composite = !MillerRabin64::isPrime(*word);
+            state.settled = true;
+            return;
+        }
+        for (int p : SMALL_PRIMES) {
+            if (n == Number(static_cast<unsigned long long>(p))) {
+                state.settled = true;
+                return;
+            }
+            if (n.modSmall(p) == 0) {
+                state.composite = true;
+                state.settled = true;
+                return;
+            }
+        }
+
+        state.d = n - Number(1);
+        while (state.d.isEven()) {
+            state.d = state.d.half();
+            ++state.s;
+        }
+        state.ctx.emplace(n);
+    }
+
+    // One strong-probable-prime round: true if `a` proves n composite.
+    template <typename Trace = SilentTrace>
+    static bool isWitness(const Number& a, const Number& d, int s, const Montgomery& ctx, const Trace& trace = {}) {
+        Number x = modPow(ctx.toMontgomery(a), d, ctx, trace);
+        if constexpr (Trace::enabled) {
+            trace.out()
+                << "  Final x class for a^m mod n => " << residueLabel(x, ctx) << "\n";
+        }
+
+        if (x == ctx.one() || x == ctx.minusOne()) {
+            if constexpr (Trace::enabled) {
+                trace.out() << "  Round result: inconclusive (candidate survives this round)\n\n";
+            }
+            return false;
+        }
+
+        for (int r = 1; r <= s - 1; ++r) {
+            x = ctx.square(x);
+            if constexpr (Trace::enabled) {
+                trace.out()
+                    << "  r = " << r
+                    << " : x = x^2 mod n => " << residueLabel(x, ctx) << "\n";
+            }
+
+            if (x == ctx.minusOne()) {
+                if constexpr (Trace::enabled) {
+                    trace.out() << "  Round result: inconclusive after squaring chain\n\n";
+                }
+                return false;
+            }
+
+            // If x becomes +1 before hitting -1, n is definitely composite.
+            if (x == ctx.one()) {
+                break;
+            }
+        }
+
+        if constexpr (Trace::enabled) {
+            trace.out() << "  Round result: witness found => composite\n";
+        }
+        return true;
+    }
+
+    // Jacobi symbol (a / n) for odd n > 0 and word-sized a.
+    static int jacobi(std::uint64_t a, std::uint64_t n) {
+        int result = 1;
+        a %= n;
+        while (a != 0) {
+            while (a % 2 == 0) {
+                a /= 2;
+                if (n % 8 == 3 || n % 8 == 5) {
+                    result = -result;
+                }
+            }
+            std::swap(a, n);
+            if (a % 4 == 3 && n % 4 == 3) {
+                result = -result;
+            }
+            a %= n;
+        }
+        return (n == 1) ? result : 0;
+    }
+
+    // Jacobi symbol (D / n) for a small signed D and a large odd n.
+    static int jacobi(long long D, const Number& n) {
+        int result = 1;
+        std::uint64_t a = static_cast<std::uint64_t>(D < 0 ? -D : D);
+        if (D < 0 && n.modSmall(4) == 3) {
+            result = -result;
+        }
+        while (a % 2 == 0) {
+            a /= 2;
+            int r = n.modSmall(8);
+            if (r == 3 || r == 5) {
+                result = -result;
+            }
+        }
+        if (a == 1) {
+            return result;
+        }
+        // Quadratic reciprocity moves the large argument into the small modulus.
+        if (a % 4 == 3 && n.modSmall(4) == 3) {
+            result = -result;
+        }
+        return result * jacobi(static_cast<std::uint64_t>(n.modSmall(static_cast<int>(a))), a);
+    }
+
+    // Residue of a small signed value modulo n.
+    static Number residueOf(long long value, const Number& n) {
+        Number magnitude = Number(static_cast<unsigned long long>(value < 0 ? -value : value)) % n;
+        return (value >= 0 || magnitude.isZero()) ? magnitude : n - magnitude;
+    }
+
+    static Number integerSqrt(const Number& n) {
+        if (n.isZero()) {
+            return n;
+        }
+        // Newton's iteration from a starting point >= sqrt(n) decreases monotonically.
+        Number x = Number::powerOfTwo((n.bitLength() + 1) / 2);
+        while (true) {
+            Number y = (x + n / x).half();
+            if (y >= x) {
+                return x;
+            }
+            x = y;
+        }
+    }
+
+    // Strong Lucas probable-prime test with Selfridge's parameters P = 1, Q = (1 - D) / 4,
+    // computed entirely in Montgomery form. Requires odd n that is not a perfect square.
+    template <typename Trace>
+    static bool isStrongLucasProbablePrime(const Number& n, const Montgomery& ctx, const Trace& trace) {
+        long long D = 5;
+        while (true) {
+            int symbol = jacobi(D, n);
+            if (symbol == -1) {
+                break;
+            }
+            if (symbol == 0) {
+                if constexpr (Trace::enabled) {
+                    trace.out() << "  D = " << D << " shares a factor with n => composite\n";
+                }
+                return false;
+            }
+            D = (D > 0) ? -(D + 2) : -D + 2;
+        }
+        long long Q = (1 - D) / 4;
+        if constexpr (Trace::enabled) {
+            trace.out() << "  Selfridge parameters: D = " << D << ", P = 1, Q = " << Q << "\n";
+        }
+
+        // n + 1 = 2^s * d with d odd.
+        Number d = n + Number(1);
+        int s = 0;
+        while (d.isEven()) {
+            d = d.half();
+            ++s;
+        }
+
+        Number mD = ctx.toMontgomery(residueOf(D, n));
+        Number mQ = ctx.toMontgomery(residueOf(Q, n));
+
+        // Left-to-right ladder over d: (U_k, V_k, Q^k) -> index 2k, then 2k + 1 on set bits.
+        Number U = ctx.one();
+        Number V = ctx.one();
+        Number Qk = mQ;
+        for (std::size_t i = d.bitLength() - 1; i-- > 0;) {
+            U = ctx.multiply(U, V);
+            V = ctx.subtract(ctx.square(V), ctx.add(Qk, Qk));
+            Qk = ctx.square(Qk);
+            if (d.testBit(i)) {
+                Number nextU = ctx.halve(ctx.add(U, V));
+                V = ctx.halve(ctx.add(ctx.multiply(mD, U), V));
+                U = nextU;
+                Qk = ctx.multiply(Qk, mQ);
+            }
+        }
+
+        if (U.isZero()) {
+            if constexpr (Trace::enabled) {
+                trace.out() << "  U_d = 0 mod n => strong Lucas probable prime\n";
+            }
+            return true;
+        }
+        for (int r = 0; r < s; ++r) {
+            if (V.isZero()) {
+                if constexpr (Trace::enabled) {
+                    trace.out() << "  V_(d*2^" << r << ") = 0 mod n => strong Lucas probable prime\n";
+                }
+                return true;
+            }
+            V = ctx.subtract(ctx.square(V), ctx.add(Qk, Qk));
+            Qk = ctx.square(Qk);
+        }
+
+        if constexpr (Trace::enabled) {
+            trace.out() << "  Neither U_d nor any V_(d*2^r) vanishes => composite\n";
+        }
+        return false;
+    }
+
+    static std::string residueLabel(const Number& x, const Montgomery& ctx) {
+        if (x == ctx.one()) {
             return "+1";
         }
-        if (x == nMinusOne) {
+        if (x == ctx.minusOne()) {
             return "-1";
         }
         return "not +/-1";
     }
 
-    static std::string toBinary(Number n) {
+    static std::string toBinary(const Number& n) {
         if (n.isZero()) {
             return "0";
         }
 
         std::string bits;
-        while (!n.isZero()) {
-            bits.push_back(n.isEven() ? '0' : '1');
-            n = n.half();
+        bits.reserve(n.bitLength());
+        for (std::size_t i = n.bitLength(); i-- > 0;) {
+            bits.push_back(n.testBit(i) ? '1' : '0');
         }
-        std::reverse(bits.begin(), bits.end());
         return bits;
     }
 
+    // Window width by exponent length, trading 2^(w-1) precomputed powers against
+    // roughly bits / (w + 1) multiplications in the main loop.
+    static int windowSize(std::size_t bits) {
+        if (bits > 671) return 6;
+        if (bits > 239) return 5;
+        if (bits > 79) return 4;
+        if (bits > 23) return 3;
+        return 1;
+    }
+
+    // Odd powers base^1, base^3, ..., base^(2^w - 1) in Montgomery form.
+    static std::vector<Number> oddPowers(const Number& base, int w, const Montgomery& ctx) {
+        std::vector<Number> table(std::size_t{1} << (w - 1));
+        table[0] = base;
+        if (table.size() > 1) {
+            Number baseSquared = ctx.square(base);
+            for (std::size_t i = 1; i < table.size(); ++i) {
+                table[i] = ctx.multiply(table[i - 1], baseSquared);
+            }
+        }
+        return table;
+    }
+
+    // Next window scanning down from bit `top` (which must be set): the window covers
+    // bits [low, top], is at most w wide and ends in a set bit. Returns its value.
+    static std::size_t nextWindow(const Number& exp, std::size_t top, int w, std::size_t& low) {
+        low = (top + 1 >= static_cast<std::size_t>(w)) ? top + 1 - w : 0;
+        while (!exp.testBit(low)) {
+            ++low;
+        }
+
+        std::size_t value = 0;
+        for (std::size_t i = top + 1; i-- > low;) {
+            value = (value << 1) | (exp.testBit(i) ? 1 : 0);
+        }
+        return value;
+    }
+
     static Number randomInRange(const Number& low, const Number& high, std::mt19937_64& rng) {
         if (low > high) {
             throw std::invalid_argument("invalid random range");
@@ -399,103 +1258,171 @@ private:
         }
 
         Number span = high - low + Number(1);
-        int len = static_cast<int>(span.toString().size());
-        std::uniform_int_distribution<int> digitDist(0, 9);
+        std::size_t bits = span.bitLength();
 
         while (true) {
-            std::string candidateStr(len, '0');
-            for (int i = 0; i < len; ++i) {
-                candidateStr[i] = static_cast<char>('0' + digitDist(rng));
-            }
-
-            Number candidate(candidateStr);
+            Number candidate = Number::randomBits(bits, rng);
             if (candidate < span) {
                 return low + candidate;
             }
         }
     }
 
-    static Number modPow(Number base, Number exp, const Number& modulus) {
-        Number result(1);
-        base = base % modulus;
+    // Left-to-right sliding-window exponentiation entirely in Montgomery form;
+    // base and result are Montgomery residues. A tracing policy reports every
+    // squaring and every window multiplication.
+    template <typename Trace = SilentTrace>
+    static Number modPow(const Number& base, const Number& exp, const Montgomery& ctx, const Trace& trace = {}) {
+        std::size_t bits = exp.bitLength();
+        int w = windowSize(bits);
+
+        if constexpr (Trace::enabled) {
+            trace.out() << "  binary(m) = " << toBinary(exp) << "\n";
+            trace.out() << "  Window size = " << w << " (precomputed odd powers a^1 .. a^" << ((1 << w) - 1) << ")\n";
+            trace.out() << "  Start: result class = +1\n";
+        }
+        if (bits == 0) {
+            return ctx.one();
+        }
 
-        while (!exp.isZero()) {
-            if (!exp.isEven()) {
-                result = (result * base) % modulus;
+        std::vector<Number> table = oddPowers(base, w, ctx);
+
+        Number result = ctx.one();
+        bool started = false;
+        [[maybe_unused]] std::size_t step = 0;
+        std::size_t i = bits;
+        while (i-- > 0) {
+            if (!exp.testBit(i)) {
+                result = ctx.square(result);
+                if constexpr (Trace::enabled) {
+                    trace.out()
+                        << "    Step " << ++step
+                        << " square => " << residueLabel(result, ctx) << "\n";
+                }
+                continue;
             }
-            exp = exp.half();
-            base = (base * base) % modulus;
+
+            std::size_t low;
+            std::size_t value = nextWindow(exp, i, w, low);
+            if (started) {
+                for (std::size_t k = low; k <= i; ++k) {
+                    result = ctx.square(result);
+                    if constexpr (Trace::enabled) {
+                        trace.out()
+                            << "    Step " << ++step
+                            << " square => " << residueLabel(result, ctx) << "\n";
+                    }
+                }
+                result = ctx.multiply(result, table[value >> 1]);
+                if constexpr (Trace::enabled) {
+                    trace.out()
+                        << "           multiply by a^" << value
+                        << " (window " << toBinary(Number(value)) << ") => " << residueLabel(result, ctx) << "\n";
+                }
+            } else {
+                // Squaring the initial 1 is a no-op, so the leading window is loaded directly.
+                result = table[value >> 1];
+                started = true;
+                if constexpr (Trace::enabled) {
+                    step += i - low + 1;
+                    trace.out()
+                        << "    Step " << step
+                        << " load a^" << value
+                        << " (window " << toBinary(Number(value)) << ") => " << residueLabel(result, ctx) << "\n";
+                }
+            }
+            i = low;
         }
         return result;
     }
 
-    static Number modPowVerbose(Number base, const Number& exp, const Number& modulus, const Number& nMinusOne, std::ostream& out) {
-        Number result(1);
-        base = base % modulus;
-
-        std::string bits = toBinary(exp);
-        out << "  binary(m) = " << bits << "\n";
-        out << "  Start: result class = +1\n";
+    // isProbablePrime<SilentTrace> for candidates handed out by a PrimeSieve: they are
+    // odd, at least 3 and free of every SMALL_PRIMES factor other than themselves, so
+    // the trial division is skipped and the rounds start right away.
+    static bool isSievedProbablePrime(const Number& n, int rounds) {
+        if (std::optional<std::uint64_t> word = n.toUint64()) {
+            return MillerRabin64::isPrime(*word);
+        }
 
-        for (std::size_t i = 0; i < bits.size(); ++i) {
-            char bit = bits[i];
+        Number d = n - Number(1);
+        int s = 0;
+        while (d.isEven()) {
+            d = d.half();
+            ++s;
+        }
 
-            result = (result * result) % modulus;
-            out
-                << "    Step " << (i + 1)
-                << " square => " << residueLabel(result, nMinusOne) << "\n";
+        Number nMinusTwo = n - Number(2);
+        Montgomery ctx(n);
 
-            if (bit == '1') {
-                result = (result * base) % modulus;
-                out
-                    << "           multiply by a => " << residueLabel(result, nMinusOne) << "\n";
+        static thread_local std::mt19937_64 rng(std::random_device{}());
+        for (int round = 1; round <= rounds; ++round) {
+            Number a = randomInRange(Number(2), nMinusTwo, rng);
+            if (isWitness(a, d, s, ctx, SilentTrace{})) {
+                return false;
             }
         }
-
-        return result;
+        return true;
     }
 
 public:
-    static bool isProbablePrime(const Number& n, int rounds = 8) {
-        static const int smallPrimes[] = {
-            2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37,
-            41, 43, 47, 53, 59, 61, 67, 71, 73, 79, 83, 89, 97
-        };
-
-        std::cout << "n = " << n.toString() << "\n";
+    // Random-base Miller-Rabin. The default ReportTrace prints the full report to
+    // std::cout; isProbablePrime<SilentTrace>(n) returns only the verdict.
+    template <typename Trace = ReportTrace>
+    static bool isProbablePrime(const Number& n, int rounds = 8, const Trace& trace = {}) {
+        if constexpr (Trace::enabled) {
+            trace.out() << "n = " << n.toString() << "\n";
+        }
 
         if (n < Number(2)) {
-            std::cout << "n < 2 => composite\n";
-            std::cout << "Prime probability (Miller-Rabin bound) = 0\n\n";
+            if constexpr (Trace::enabled) {
+                trace.out() << "n < 2 => composite\n";
+                trace.out() << "Prime probability (Miller-Rabin bound) = 0\n\n";
+            }
             return false;
         }
 
         if (n == Number(2) || n == Number(3)) {
-            std::cout << "n is a small prime by definition\n";
-            std::cout << "Prime probability = 1\n\n";
+            if constexpr (Trace::enabled) {
+                trace.out() << "n is a small prime by definition\n";
+                trace.out() << "Prime probability = 1\n\n";
+            }
             return true;
         }
 
         if (n.isEven()) {
-            std::cout << "n is even and > 2 => composite\n";
-            std::cout << "Prime probability (Miller-Rabin bound) = 0\n\n";
+            if constexpr (Trace::enabled) {
+                trace.out() << "n is even and > 2 => composite\n";
+                trace.out() << "Prime probability (Miller-Rabin bound) = 0\n\n";
+            }
             return false;
         }
 
-        bool divisibleBySmallPrime = false;
-        int foundSmallFactor = -1;
-        for (int p : smallPrimes) {
+        for (int p : SMALL_PRIMES) {
             Number prime(static_cast<unsigned long long>(p));
             if (n == prime) {
-                std::cout << "n equals small prime " << p << "\n";
-                std::cout << "Prime probability = 1\n\n";
+                if constexpr (Trace::enabled) {
+                    trace.out() << "n equals small prime " << p << "\n";
+                    trace.out() << "Prime probability = 1\n\n";
+                }
                 return true;
             }
             if (n.modSmall(p) == 0) {
-                divisibleBySmallPrime = true;
-                foundSmallFactor = p;
-                break;
+                if constexpr (Trace::enabled) {
+                    trace.out() << "Pre-check: n is divisible by small prime " << p << " => composite for sure\n";
+                    trace.out() << "Prime probability (Miller-Rabin bound) = 0\n\n";
+                }
+                return false;
+            }
+        }
+
+        if (std::optional<std::uint64_t> word = n.toUint64()) {
+            bool prime = MillerRabin64::isPrime(*word);
+            if constexpr (Trace::enabled) {
+                trace.out() << "n < 2^64 => deterministic Miller-Rabin with bases 2, 325, 9375, 28178, 450775, 9780504, 1795265022\n";
+                trace.out() << "Result: " << (prime ? "prime" : "composite") << "\n";
+                trace.out() << "Prime probability = " << (prime ? 1 : 0) << "\n\n";
             }
+            return prime;
         }
 
         Number d = n - Number(1);
@@ -505,77 +1432,178 @@ public:
             ++s;
         }
 
-        Number nMinusOne = n - Number(1);
         Number nMinusTwo = n - Number(2);
 
-        std::cout << "n - 1 = 2^k * m\n";
-        std::cout << "k = " << s << "\n";
-        std::cout << "m = " << d.toString() << "\n\n";
-
-        if (divisibleBySmallPrime) {
-            std::cout << "Pre-check: n is divisible by small prime " << foundSmallFactor << " => composite for sure\n";
-            std::cout << "Continuing with Miller-Rabin rounds for a full trace.\n\n";
+        if constexpr (Trace::enabled) {
+            trace.out() << "n - 1 = 2^k * m\n";
+            trace.out() << "k = " << s << "\n";
+            trace.out() << "m = " << d.toString() << "\n\n";
         }
 
+        Montgomery ctx(n);
+
         std::random_device rd;
         std::mt19937_64 rng(rd());
 
         for (int round = 1; round <= rounds; ++round) {
             Number a = randomInRange(Number(2), nMinusTwo, rng);
-            std::cout << "Round " << round << ": a = " << a.toString() << "\n";
-            std::cout << "  Compute x = a^m mod n via square-and-multiply\n";
-
-            Number x = modPowVerbose(a, d, n, nMinusOne, std::cout);
-            std::cout
-                << "  Final x class for a^m mod n => " << residueLabel(x, nMinusOne) << "\n";
+            if constexpr (Trace::enabled) {
+                trace.out() << "Round " << round << ": a = " << a.toString() << "\n";
+                trace.out() << "  Compute x = a^m mod n via square-and-multiply\n";
+            }
 
-            if (x == Number(1) || x == nMinusOne) {
-                std::cout << "  Round result: inconclusive (candidate survives this round)\n\n";
-                continue;
+            if (isWitness(a, d, s, ctx, trace)) {
+                if constexpr (Trace::enabled) {
+                    trace.out() << "Prime probability (Miller-Rabin bound) = 0\n\n";
+                }
+                return false;
             }
+        }
 
-            bool reachedMinusOne = false;
-            for (int r = 1; r <= s - 1; ++r) {
-                x = (x * x) % n;
-                std::cout
-                    << "  r = " << r
-                    << " : x = x^2 mod n => " << residueLabel(x, nMinusOne) << "\n";
+        if constexpr (Trace::enabled) {
+            long double falsePrimeUpperBound = std::pow(0.25L, static_cast<long double>(rounds));
+            long double confidence = 1.0L - falsePrimeUpperBound;
+            trace.out() << "All rounds inconclusive.\n";
+            trace.out() << "False-prime upper bound <= 4^-" << rounds << " = "
+                        << std::setprecision(18) << falsePrimeUpperBound << "\n";
+            trace.out() << "Prime probability lower bound >= "
+                        << std::setprecision(18) << confidence << "\n\n";
+        }
 
-                if (x == nMinusOne) {
-                    reachedMinusOne = true;
-                    break;
-                }
+        return true;
+    }
 
-                // If x becomes +1 before hitting -1, n is definitely composite.
-                if (x == Number(1)) {
-                    break;
-                }
+    // Baillie-PSW: one base-2 strong probable-prime round followed by a strong Lucas
+    // test. No composite is known to pass both, and the cost is about three
+    // Miller-Rabin rounds.
+    template <typename Trace = ReportTrace>
+    static bool isBailliePSW(const Number& n, const Trace& trace = {}) {
+        if constexpr (Trace::enabled) {
+            trace.out() << "n = " << n.toString() << "\n";
+        }
+
+        if (std::optional<std::uint64_t> word = n.toUint64()) {
+            bool prime = MillerRabin64::isPrime(*word);
+            if constexpr (Trace::enabled) {
+                trace.out() << "n < 2^64 => deterministic Miller-Rabin decides: " << (prime ? "prime" : "composite") << "\n\n";
             }
+            return prime;
+        }
 
-            if (!reachedMinusOne) {
-                std::cout << "  Round result: witness found => composite\n";
-                std::cout << "Prime probability (Miller-Rabin bound) = 0\n\n";
+        for (int p : SMALL_PRIMES) {
+            if (n.modSmall(p) == 0) {
+                if constexpr (Trace::enabled) {
+                    trace.out() << "Pre-check: n is divisible by small prime " << p << " => composite for sure\n\n";
+                }
                 return false;
             }
+        }
+
+        Number d = n - Number(1);
+        int s = 0;
+        while (d.isEven()) {
+            d = d.half();
+            ++s;
+        }
+
+        Montgomery ctx(n);
 
-            std::cout << "  Round result: inconclusive after squaring chain\n\n";
+        if constexpr (Trace::enabled) {
+            trace.out() << "Base-2 strong probable-prime round\n";
+        }
+        if (isWitness(Number(2), d, s, ctx, trace)) {
+            if constexpr (Trace::enabled) {
+                trace.out() << "BPSW result: composite\n\n";
+            }
+            return false;
         }
 
-        if (divisibleBySmallPrime) {
-            std::cout << "All rounds inconclusive, but small-prime divisibility already proved composite.\n";
-            std::cout << "Prime probability (Miller-Rabin bound) = 0\n\n";
+        Number root = integerSqrt(n);
+        if (root * root == n) {
+            if constexpr (Trace::enabled) {
+                trace.out() << "n is a perfect square => composite\n";
+                trace.out() << "BPSW result: composite\n\n";
+            }
             return false;
         }
 
-        long double falsePrimeUpperBound = std::pow(0.25L, static_cast<long double>(rounds));
-        long double confidence = 1.0L - falsePrimeUpperBound;
-        std::cout << "All rounds inconclusive.\n";
-        std::cout << "False-prime upper bound <= 4^-" << rounds << " = "
-                  << std::setprecision(18) << falsePrimeUpperBound << "\n";
-        std::cout << "Prime probability lower bound >= "
-                  << std::setprecision(18) << confidence << "\n\n";
+        if constexpr (Trace::enabled) {
+            trace.out() << "Strong Lucas test\n";
+        }
+        bool prime = isStrongLucasProbablePrime(n, ctx, trace);
+        if constexpr (Trace::enabled) {
+            trace.out() << "BPSW result: " << (prime ? "probably prime" : "composite") << "\n\n";
+        }
+        return prime;
+    }
 
-        return true;
+    // Tests every candidate with `rounds` random-base rounds and no output. Each
+    // (candidate, round) pair is a pool task; once any round finds a witness, the
+    // remaining rounds of that candidate are skipped. verdicts[i] is true for
+    // probable primes.
+    static std::vector<bool> isProbablePrimeBatch(
+        std::span<const Number> candidates,
+        int rounds = 8,
+        unsigned threadCount = std::thread::hardware_concurrency()
+    ) {
+        std::vector<BatchCandidate> states(candidates.size());
+        std::size_t roundsPerCandidate = static_cast<std::size_t>(std::max(rounds, 1));
+
+        WorkStealingPool pool(threadCount);
+        pool.run(candidates.size() * roundsPerCandidate, [&](std::size_t task) {
+            const Number& n = candidates[task / roundsPerCandidate];
+            BatchCandidate& state = states[task / roundsPerCandidate];
+
+            std::call_once(state.prepared, prepareCandidate, std::cref(n), std::ref(state));
+            if (state.settled || state.composite.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            static thread_local std::mt19937_64 rng(std::random_device{}());
+            Number a = randomInRange(Number(2), n - Number(2), rng);
+            if (isWitness(a, state.d, state.s, *state.ctx, SilentTrace{})) {
+                state.composite.store(true, std::memory_order_relaxed);
+            }
+        });
+
+        std::vector<bool> verdicts(candidates.size());
+        for (std::size_t i = 0; i < candidates.size(); ++i) {
+            verdicts[i] = !states[i].composite;
+        }
+        return verdicts;
+    }
+
+    // Smallest probable prime >= from. Candidates come from a PrimeSieve, so only
+    // values without small factors are exponentiated, and they go straight to the
+    // Miller-Rabin rounds.
+    static Number nextPrime(const Number& from, int rounds = 8) {
+        if (from <= Number(2)) {
+            return Number(2);
+        }
+
+        PrimeSieve sieve(from);
+        while (true) {
+            Number candidate = sieve.next();
+            if (isSievedProbablePrime(candidate, rounds)) {
+                return candidate;
+            }
+        }
+    }
+
+    // Random probable prime with exactly `bits` bits (bits >= 2).
+    static Number randomPrime(std::size_t bits, int rounds = 8) {
+        if (bits < 2) {
+            throw std::invalid_argument("a prime needs at least 2 bits");
+        }
+
+        static thread_local std::mt19937_64 rng(std::random_device{}());
+        while (true) {
+            Number start = Number::randomBits(bits - 1, rng) + Number::powerOfTwo(bits - 1);
+            Number prime = nextPrime(start, rounds);
+            if (prime.bitLength() == bits) {
+                return prime;
+            }
+        }
     }
 };
 
@@ -603,5 +1631,25 @@ int main() {
         std::cout << "============================================================\n\n";
     }
 
+    std::vector<Number> batch;
+    for (const TestCase& test : tests) {
+        batch.emplace_back(test.value);
+    }
+    std::vector<bool> verdicts = MillerRabin::isProbablePrimeBatch(batch, 6);
+    std::cout << "Batch verdicts:";
+    for (bool prime : verdicts) {
+        std::cout << " " << (prime ? "prime" : "composite");
+    }
+    std::cout << "\n";
+
+    std::cout << "BPSW verdicts:";
+    for (const Number& n : batch) {
+        std::cout << " " << (MillerRabin::isBailliePSW<SilentTrace>(n) ? "prime" : "composite");
+    }
+    std::cout << "\n";
+
+    std::cout << "Next prime after 10^100: " << MillerRabin::nextPrime(Number("1" + std::string(100, '0'))).toString() << "\n";
+    std::cout << "Random 512-bit prime: " << MillerRabin::randomPrime(512).toString() << "\n";
+
     return 0;
 }
\ No newline at end of file
@@ -1,15 +1,52 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <unordered_map>
 #include <print> // Using C++ 23 (:
 #include <optional>
+#include <array>
+#include <cmath>
+#include <fstream>	// to load quadgram statistics
+#include <numeric>
+#include <random>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <string_view>
+#include <sstream>	// to parse workbench commands
+#include <cctype>
+#include <span>
+#include <iterator>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+#include "../common/ngram.hpp"
 
 class SubstitutionCipher {
 public:
-	// Maps to store key and inverse key. 
-	std::unordered_map<char, char> key;
-	std::unordered_map<char, char> inverseKey;
+	// Flat tables indexed by the byte value: key[p] is the ciphertext letter for plaintext `p`
+	// ('\0' if not set yet), inverseKey[c] the plaintext letter for ciphertext `c` ('-' if not set yet).
+	std::array<char, 256> key{};
+	std::array<char, 256> inverseKey{};
+
+	// One table entry overwritten by addKey or removeKey: inverseKey[index] if `inverse`, else key[index].
+	struct Overwrite {
+		bool inverse;
+		char index;
+		char previous;
+	};
+
+private:
+	void write(bool inverse, char index, char value, std::vector<Overwrite>* undo) {
+		char& entry = (inverse ? inverseKey : key)[static_cast<unsigned char>(index)];
+		if (entry == value) return;
+		if (undo != nullptr) undo->push_back({inverse, index, entry});
+		entry = value;
+	}
+
+public:
 
 	SubstitutionCipher() {
 		// Initialize all keys to `-`.
@@ -22,7 +59,9 @@ public:
 	// One can add the key into the map as soon as he becomes sure about it. 
 	// `p`: plaintext character
 	// `c`: ciphertext character which the cryptanalyst thinks `p` maps to
-	void addKey(char p, char c) {
+	// A previous mapping of `p` or of `c` is removed, so both tables stay one-to-one.
+	// If `undo` is given, every overwritten entry is appended to it (see restore).
+	void addKey(char p, char c, std::vector<Overwrite>* undo = nullptr) {
 		if (p < 'a' || p > 'z') {
 			std::println(stderr, "Error: Plaintext should consist of only lowercase english letters.");
 			return;
@@ -33,49 +72,112 @@ public:
 			return;
 		}
 
-		key[p] = c;
-		inverseKey[c] = p;
+		char oldCipher = key[p], oldPlain = inverseKey[c];
+		if (oldCipher != c && inverseKey[static_cast<unsigned char>(oldCipher)] == p) write(true, oldCipher, '-', undo);
+		if (oldPlain != p && key[static_cast<unsigned char>(oldPlain)] == c) write(false, oldPlain, '\0', undo);
+		write(false, p, c, undo);
+		write(true, c, p, undo);
 	}
 
-	std::optional<std::string> decrypt(std::string ciphertext) {
-		std::string decrypted;
-		decrypted.reserve(ciphertext.length());
+	// Forgets the mapping of plaintext letter `p`, if any.
+	void removeKey(char p, std::vector<Overwrite>* undo = nullptr) {
+		if (p < 'a' || p > 'z') {
+			std::println(stderr, "Error: Plaintext should consist of only lowercase english letters.");
+			return;
+		}
 
-		for (char ch : ciphertext) {
-			decrypted.push_back(inverseKey[ch]);
+		char c = key[p];
+		if (c == '\0') return;
+		if (inverseKey[static_cast<unsigned char>(c)] == p) write(true, c, '-', undo);
+		write(false, p, '\0', undo);
+	}
+
+	// Puts back the entries recorded by addKey or removeKey, undoing that change.
+	void restore(const std::vector<Overwrite>& undo) {
+		for (auto it = undo.rbegin(); it != undo.rend(); ++it) {
+			(it->inverse ? inverseKey : key)[static_cast<unsigned char>(it->index)] = it->previous;
 		}
+	}
+
+	// Bulk decryption of n bytes into a caller-provided buffer; bytes outside 'A'..'Z' become '\0'.
+	// With SSSE3/AVX2 each block of 16/32 bytes is mapped by two byte shuffles (pshufb) over the
+	// 26-entry table, selected by whether the letter index is below 16. The shuffle tables are loaded
+	// straight from inverseKey['A'..] and inverseKey['Q'..] on every call, so direct writes to
+	// inverseKey are always seen; lanes past 'Z' in the second table are masked off as non-letters.
+	void decrypt(const char* in, char* out, size_t n) const {
+		size_t i = 0;
+
+#if defined(__AVX2__)
+		const __m256i lowTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(inverseKey.data() + 'A')));
+		const __m256i highTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(inverseKey.data() + 'Q')));
+		for (; i + 32 <= n; i += 32) {
+			__m256i index = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), _mm256_set1_epi8('A'));
+			__m256i isLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(index, _mm256_set1_epi8(25)), index);
+			__m256i isLow = _mm256_cmpeq_epi8(_mm256_min_epu8(index, _mm256_set1_epi8(15)), index);
+			__m256i fromLow = _mm256_shuffle_epi8(lowTable, index);
+			__m256i fromHigh = _mm256_shuffle_epi8(highTable, _mm256_sub_epi8(index, _mm256_set1_epi8(16)));
+			__m256i mapped = _mm256_blendv_epi8(fromHigh, fromLow, isLow);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_and_si256(mapped, isLetter));
+		}
+#endif
 
+#if defined(__SSSE3__)
+		const __m128i lowTable128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inverseKey.data() + 'A'));
+		const __m128i highTable128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inverseKey.data() + 'Q'));
+		for (; i + 16 <= n; i += 16) {
+			__m128i index = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), _mm_set1_epi8('A'));
+			__m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(index, _mm_set1_epi8(25)), index);
+			__m128i isLow = _mm_cmpeq_epi8(_mm_min_epu8(index, _mm_set1_epi8(15)), index);
+			__m128i fromLow = _mm_shuffle_epi8(lowTable128, index);
+			__m128i fromHigh = _mm_shuffle_epi8(highTable128, _mm_sub_epi8(index, _mm_set1_epi8(16)));
+			__m128i mapped = _mm_or_si128(_mm_and_si128(isLow, fromLow), _mm_andnot_si128(isLow, fromHigh));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_and_si128(mapped, isLetter));
+		}
+#endif
+
+		for (; i < n; ++i) {
+			unsigned char ch = static_cast<unsigned char>(in[i]);
+			out[i] = ch >= 'A' && ch <= 'Z' ? inverseKey[ch] : '\0';
+		}
+	}
+
+	std::optional<std::string> decrypt(const std::string& ciphertext) const {
+		std::string decrypted(ciphertext.length(), '\0');
+		decrypt(ciphertext.data(), decrypted.data(), ciphertext.length());
 		return decrypted;
 	}
 
-	std::optional<std::string> encrypt(std::string plaintext) {
-		std::string encrypted;
-		encrypted.reserve(plaintext.length());
+	std::optional<std::string> encrypt(const std::string& plaintext) const {
+		std::string encrypted(plaintext.length(), '\0');
 
-		for (char ch : plaintext) {
-			if (key.find(ch) == key.end()) {
-				std::println(stderr, "Error: Cannot encrypt character: {0} Please provide a key first.", ch);
+		for (size_t i = 0; i < plaintext.length(); ++i) {
+			char ch = key[static_cast<unsigned char>(plaintext[i])];
+			if (ch == '\0') {
+				std::println(stderr, "Error: Cannot encrypt character: {0} Please provide a key first.", plaintext[i]);
 				return std::nullopt;
 			}
-			encrypted.push_back(key[ch]);
+			encrypted[i] = ch;
 		}
 
 		return encrypted;
 	}
 
-	void decryptAndPrint(std::string ciphertext, int cols = 100) {
+	// Prints row `row` of a ciphertext/plaintext pair split into rows of `cols` characters.
+	// Uses views into both strings, so no row is ever copied.
+	static void printRow(std::string_view ciphertext, std::string_view plaintext, size_t row, int cols) {
+		size_t begin = row * cols;
+		std::println(stdout, "{}", ciphertext.substr(begin, cols));
+		std::println(stdout, "{}", plaintext.substr(begin, cols));
+	}
+
+	void decryptAndPrint(const std::string& ciphertext, int cols = 100) {
 		auto decrypted = decrypt(ciphertext);
 		if (decrypted == std::nullopt) return;
 
-		int ind = 0;
-		while (ind < ciphertext.length() - cols) {
-			std::println(stdout, "{}", ciphertext.substr(ind, cols));
-			std::println(stdout, "{}", (*decrypted).substr(ind, cols));
-			ind += cols;
+		size_t rows = std::max<size_t>(1, (ciphertext.length() + cols - 1) / cols);
+		for (size_t row = 0; row < rows; ++row) {
+			printRow(ciphertext, *decrypted, row, cols);
 		}
-
-		std::println(stdout, "{}", ciphertext.substr(ind, std::min(cols, int(ciphertext.length()) - ind)));
-		std::println(stdout, "{}", (*decrypted).substr(ind, std::min(cols, int(ciphertext.length()) - ind)));
 		std::println();
 	}
 
@@ -85,18 +187,700 @@ public:
 	}
 };
 
-void printFrequenciesSorted(std::unordered_map<std::string, int> freqMap, int cols) {
-	std::vector<std::pair<int, std::string>> freqArray;
-	for (auto [k, v] : freqMap) {
-		freqArray.push_back({v, k});
+// English quadgram statistics used as the fitness of a candidate plaintext.
+// quadgrams.txt holds "ABCD count" lines, counted by make-quadgrams.py over the ~437k letters
+// of Newton's Opticks (corpus/, public domain); quadgrams missing from it get a floor probability.
+class QuadgramScorer {
+	std::optional<std::vector<float>> logProb;		// log10 probability of each base-26 quadgram code
+	std::string quadgramsFile = "quadgrams.txt";
+
+public:
+	QuadgramScorer() {
+		std::ifstream inFile(quadgramsFile);
+		if (!inFile) {
+			std::println(stderr, "Error: Unable to open {}.", quadgramsFile);
+			return;
+		}
+
+		std::vector<double> counts(26 * 26 * 26 * 26, 0);
+		double total = 0;
+		std::string quadgram;
+		double count;
+		while (inFile >> quadgram >> count) {
+			if (quadgram.length() != 4 || !std::all_of(quadgram.begin(), quadgram.end(), [](char ch) { return ch >= 'A' && ch <= 'Z'; })) {
+				std::println(stderr, "Error: {} should consist only of uppercase quadgrams and their counts.", quadgramsFile);
+				return;
+			}
+			int code = 0;
+			for (char ch : quadgram) code = code * 26 + (ch - 'A');
+			counts[code] += count;
+			total += count;
+		}
+		if (total == 0) {
+			std::println(stderr, "Error: {} is empty.", quadgramsFile);
+			return;
+		}
+
+		std::vector<float> table(counts.size());
+		float floor = std::log10(0.01 / total);
+		for (int i = 0; i < static_cast<int>(counts.size()); ++i) {
+			table[i] = counts[i] > 0 ? std::log10(counts[i] / total) : floor;
+		}
+		logProb = std::move(table);
+	}
+
+	bool isLoaded() const {
+		return logProb.has_value();
+	}
+
+	// log10 probability of the quadgram with letters (a, b, c, d), each in 0..25
+	float operator()(int a, int b, int c, int d) const {
+		return (*logProb)[((a * 26 + b) * 26 + c) * 26 + d];
+	}
+};
+
+// Limits for SubstitutionSolver::solveParallel; the search stops at whichever is hit first.
+struct SolveBudget {
+	int restarts = 256;										// annealing runs across all threads; at least 1 is run
+	std::chrono::milliseconds time{1000};					// wall-clock limit, checked between runs
+	std::optional<double> targetFitness;					// stop once the mean log10 probability per quadgram reaches this
+	unsigned threads = std::thread::hardware_concurrency();	// 0 means 1
+};
+
+// A complete key found by the solver: plainOf[c] is the plaintext letter (0..25)
+// for ciphertext letter 'A' + c, with the quadgram fitness of the resulting plaintext.
+struct SolvedKey {
+	std::array<int, 26> plainOf;
+	double fitness;
+
+	// Fills the cipher's key and inverseKey with this permutation.
+	void applyTo(SubstitutionCipher& cipher) const {
+		for (int c = 0; c < 26; ++c) {
+			cipher.addKey('a' + plainOf[c], 'A' + c);
+		}
+	}
+};
+
+// Automatic solver: random-restart simulated annealing over the 26! keys, maximizing quadgram fitness.
+// Swapping the plaintext letters of ciphertext letters x and y only changes the quadgrams
+// that contain an x or a y, so each candidate swap rescores just those quadgrams.
+class SubstitutionSolver {
+	const QuadgramScorer& scorer;
+	std::vector<int> text;							// ciphertext letters as 0..25 (other characters dropped)
+	std::array<std::vector<int>, 26> quadgramsOf;	// start positions of the quadgrams containing each letter
+
+	float quadgramScore(const std::array<int, 26>& plainOf, int start) const {
+		return scorer(plainOf[text[start]], plainOf[text[start + 1]], plainOf[text[start + 2]], plainOf[text[start + 3]]);
+	}
+
+public:
+	SubstitutionSolver(const QuadgramScorer& scorer, const std::string& ciphertext) : scorer(scorer) {
+		for (char ch : ciphertext) {
+			if (ch >= 'A' && ch <= 'Z') text.push_back(ch - 'A');
+		}
+		for (int start = 0; start + 4 <= static_cast<int>(text.size()); ++start) {
+			for (int i = 0; i < 4; ++i) {
+				int letter = text[start + i];
+				// Each quadgram is listed once per distinct letter it contains
+				if (quadgramsOf[letter].empty() || quadgramsOf[letter].back() != start) {
+					quadgramsOf[letter].push_back(start);
+				}
+			}
+		}
+	}
+
+	// A uniformly random key.
+	static std::array<int, 26> randomKey(std::mt19937& rng) {
+		std::array<int, 26> plainOf;
+		std::iota(plainOf.begin(), plainOf.end(), 0);
+		std::shuffle(plainOf.begin(), plainOf.end(), rng);
+		return plainOf;
+	}
+
+	// Change in fitness if the plaintext letters of ciphertext letters x and y were swapped.
+	// Quadgrams containing both x and y appear in both lists; they are counted via x only.
+	double swapDelta(std::array<int, 26>& plainOf, const std::vector<float>& scores, int x, int y) const {
+		double delta = 0;
+		std::swap(plainOf[x], plainOf[y]);
+		for (int start : quadgramsOf[x]) {
+			delta += quadgramScore(plainOf, start) - scores[start];
+		}
+		for (int start : quadgramsOf[y]) {
+			if (text[start] == x || text[start + 1] == x || text[start + 2] == x || text[start + 3] == x) continue;
+			delta += quadgramScore(plainOf, start) - scores[start];
+		}
+		std::swap(plainOf[x], plainOf[y]);
+		return delta;
+	}
+
+	// One run from `start` by simulated annealing: random swaps are always taken when they
+	// improve the fitness, and taken with probability exp(delta / T) otherwise, where the
+	// temperature T falls linearly to 0. The walk ends as a plain hill climb at T = 0.
+	SolvedKey anneal(const std::array<int, 26>& start, std::mt19937& rng, int iterations = 10000) const {
+		SolvedKey current;
+		current.plainOf = start;
+		std::vector<float> scores(text.size() >= 4 ? text.size() - 3 : 0);
+		current.fitness = 0;
+		for (int i = 0; i < static_cast<int>(scores.size()); ++i) {
+			scores[i] = quadgramScore(current.plainOf, i);
+			current.fitness += scores[i];
+		}
+		SolvedKey best = current;
+
+		// Longer texts have larger fitness swings per swap, so they start hotter.
+		const double startTemperature = 0.05 * scores.size() + 2;
+		std::uniform_int_distribution<int> letter(0, 25);
+		std::uniform_real_distribution<double> chance(0.0, 1.0);
+		for (int i = 0; i < iterations; ++i) {
+			int x = letter(rng), y = letter(rng);
+			if (x == y || (quadgramsOf[x].empty() && quadgramsOf[y].empty())) continue;
+
+			double delta = swapDelta(current.plainOf, scores, x, y);
+			double temperature = startTemperature * (iterations - i) / iterations;
+			if (delta <= 0 && chance(rng) >= std::exp(delta / temperature)) continue;
+
+			std::swap(current.plainOf[x], current.plainOf[y]);
+			for (int start : quadgramsOf[x]) scores[start] = quadgramScore(current.plainOf, start);
+			for (int start : quadgramsOf[y]) scores[start] = quadgramScore(current.plainOf, start);
+			current.fitness += delta;
+			if (current.fitness > best.fitness) best = current;
+		}
+
+		return best;
+	}
+
+	// Runs `restarts` independent annealing runs from random keys and keeps the fittest key.
+	SolvedKey solve(int restarts = 8, unsigned seed = std::random_device{}()) const {
+		std::mt19937 rng(seed);
+		SolvedKey best = anneal(randomKey(rng), rng);
+		for (int i = 1; i < restarts; ++i) {
+			SolvedKey candidate = anneal(randomKey(rng), rng);
+			if (candidate.fitness > best.fitness) best = candidate;
+		}
+		return best;
+	}
+
+	// Runs annealing restarts on `budget.threads` threads, each with its own RNG seeded from `seed`.
+	// Threads claim runs from a shared counter and publish their best fitness with a compare-and-swap
+	// on one atomic, so they can stop early once anyone reaches the target without taking a lock.
+	// Each thread keeps its own best key; the fittest is picked after they are joined.
+	SolvedKey solveParallel(const SolveBudget& budget, unsigned seed = std::random_device{}()) const {
+		unsigned threads = std::max(1u, budget.threads);
+		int restarts = std::max(1, budget.restarts);
+		auto deadline = std::chrono::steady_clock::now() + budget.time;
+		double quadgrams = std::max<double>(1, text.size() >= 4 ? text.size() - 3 : 0);
+		double target = budget.targetFitness ? *budget.targetFitness * quadgrams : std::numeric_limits<double>::infinity();
+
+		std::atomic<int> nextRun{0};
+		std::atomic<double> bestFitness{-std::numeric_limits<double>::infinity()};
+		std::vector<std::optional<SolvedKey>> bestOf(threads);
+
+		auto worker = [&](unsigned t) {
+			std::mt19937 rng(seed + t * 0x9E3779B9u);
+			while (nextRun++ < restarts) {
+				if (bestFitness.load(std::memory_order_relaxed) >= target) break;
+				if (std::chrono::steady_clock::now() >= deadline && bestOf[t]) break;
+
+				SolvedKey candidate = anneal(randomKey(rng), rng);
+				if (!bestOf[t] || candidate.fitness > bestOf[t]->fitness) bestOf[t] = candidate;
+
+				double seen = bestFitness.load(std::memory_order_relaxed);
+				while (candidate.fitness > seen && !bestFitness.compare_exchange_weak(seen, candidate.fitness, std::memory_order_relaxed)) {
+				}
+			}
+		};
+
+		std::vector<std::thread> pool;
+		for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+		worker(0);
+		for (auto& thread : pool) thread.join();
+
+		// Some thread has a key: run 0 is always claimed, and the thread that claims a run only skips
+		// it once the target is reached (so some run has finished) or the deadline passed while it
+		// already has a key of its own.
+		std::optional<SolvedKey> best;
+		for (const auto& key : bestOf) {
+			if (key && (!best || key->fitness > best->fitness)) best = key;
+		}
+		return *best;
+	}
+};
+
+// An analyst's working session on one ciphertext: keeps its decryption up to date as mappings
+// are added. Every ciphertext letter has an index of the positions where it occurs, so a new
+// mapping patches only those positions, and only the rows they fall in are printed again.
+class DecryptionSession {
+	SubstitutionCipher cipher;
+	std::string ciphertext;
+	std::string plaintext;							// current decryption of `ciphertext`
+	std::array<std::vector<size_t>, 26> positionsOf;	// positions of each ciphertext letter, ascending
+	int cols;
+
+public:
+	DecryptionSession(std::string ciphertext, int cols = 100) : ciphertext(std::move(ciphertext)), cols(std::max(1, cols)) {
+		plaintext = *cipher.decrypt(this->ciphertext);
+		for (size_t i = 0; i < this->ciphertext.length(); ++i) {
+			char ch = this->ciphertext[i];
+			if (ch >= 'A' && ch <= 'Z') positionsOf[ch - 'A'].push_back(i);
+		}
+	}
+
+	const SubstitutionCipher& getCipher() const {
+		return cipher;
+	}
+
+	const std::string& getPlaintext() const {
+		return plaintext;
+	}
+
+	size_t rowCount() const {
+		return std::max<size_t>(1, (ciphertext.length() + cols - 1) / cols);
+	}
+
+	// Rewrites the positions of ciphertext letter `c` with its current decryption.
+	// Returns the rows whose plaintext changed, in ascending order.
+	std::vector<size_t> patch(char c) {
+		std::vector<size_t> changedRows;
+		if (c < 'A' || c > 'Z') return changedRows;
+
+		const auto& positions = positionsOf[c - 'A'];
+		char plain = cipher.inverseKey[c];
+		if (positions.empty() || plaintext[positions.front()] == plain) return changedRows;
+
+		for (size_t i : positions) {
+			plaintext[i] = plain;
+			size_t row = i / cols;
+			if (changedRows.empty() || changedRows.back() != row) changedRows.push_back(row);
+		}
+		return changedRows;
+	}
+
+	// Patches every ciphertext letter whose inverseKey entry appears in `written`.
+	// Returns the union of their changed rows, in ascending order.
+	std::vector<size_t> patch(const std::vector<SubstitutionCipher::Overwrite>& written) {
+		std::vector<size_t> changedRows;
+		for (const auto& entry : written) {
+			if (!entry.inverse) continue;
+			std::vector<size_t> rows = patch(entry.index), merged;
+			std::set_union(changedRows.begin(), changedRows.end(), rows.begin(), rows.end(), std::back_inserter(merged));
+			changedRows = std::move(merged);
+		}
+		return changedRows;
+	}
+
+	// Adds the mapping p -> c and patches the decryption where `c` occurs, and where the
+	// ciphertext letter that `p` used to map to occurs. Returns the rows whose plaintext changed,
+	// in ascending order. The overwritten key entries are appended to `undo` if given.
+	std::vector<size_t> addKey(char p, char c, std::vector<SubstitutionCipher::Overwrite>* undo = nullptr) {
+		std::vector<SubstitutionCipher::Overwrite> written;
+		cipher.addKey(p, c, &written);
+		if (undo != nullptr) undo->insert(undo->end(), written.begin(), written.end());
+		return patch(written);
+	}
+
+	// Forgets the mapping of `p` and patches the decryption where its ciphertext letter occurs.
+	std::vector<size_t> removeKey(char p, std::vector<SubstitutionCipher::Overwrite>* undo = nullptr) {
+		std::vector<SubstitutionCipher::Overwrite> written;
+		cipher.removeKey(p, &written);
+		if (undo != nullptr) undo->insert(undo->end(), written.begin(), written.end());
+		return patch(written);
+	}
+
+	// Undoes an addKey or removeKey given the entries it recorded.
+	std::vector<size_t> restore(const std::vector<SubstitutionCipher::Overwrite>& undo) {
+		cipher.restore(undo);
+		return patch(undo);
+	}
+
+	void printRows(const std::vector<size_t>& rows) const {
+		for (size_t row : rows) {
+			SubstitutionCipher::printRow(ciphertext, plaintext, row, cols);
+		}
+		std::println();
+	}
+
+	void print() const {
+		for (size_t row = 0; row < rowCount(); ++row) {
+			SubstitutionCipher::printRow(ciphertext, plaintext, row, cols);
+		}
+		std::println();
+	}
+
+	// Adds the mapping and prints only the rows it changed.
+	void addKeyAndPrint(char p, char c) {
+		auto rows = addKey(p, c);
+		std::println("{} -> {}: {} of {} rows changed", p, c, rows.size(), rowCount());
+		printRows(rows);
+	}
+};
+
+// Interactive workbench over a DecryptionSession: reads commands such as `t=P`, `undo` or `suggest`
+// and keeps the decryption and the quadgram fitness current after each one. The n-gram tables are
+// only decoded against the current key when `stats` asks for them.
+// A change touches at most two ciphertext letters (the new one and the one `p` is moved off), so
+// the fitness is updated from the quadgrams that contain those letters, and a change is undone by
+// restoring the key entries it overwrote.
+class Workbench {
+	// One `p=C` (addKey) or `p=` (removeKey, c == '\0') and the key entries it overwrote.
+	struct KeyChange {
+		char p, c;
+		std::vector<SubstitutionCipher::Overwrite> written;
+	};
+
+	static constexpr size_t PAGE_ROWS = 8;			// rows shown by `view`
+	static constexpr size_t SUGGEST_SAMPLE = 256;	// quadgrams per ciphertext letter tried by `suggest`
+	static constexpr size_t SUGGEST_SCAN = 1024;	// quadgrams per ciphertext letter searched for that sample
+	static constexpr char ENGLISH_ORDER[] = "etaoinshrdlcumwfgypbvkjxqz";
+
+	DecryptionSession session;
+	const QuadgramScorer& scorer;
+	std::string ciphertext;
+	std::vector<KeyChange> undoStack, redoStack;
+	NGramCounter monogram, digram, trigram;
+
+	// Quadgram fitness of the decrypted part: only quadgrams whose four letters are all mapped count.
+	std::array<std::vector<size_t>, 26> quadgramsOf;	// start positions of the quadgrams containing each letter
+	std::vector<float> quadgramScores;					// NaN while a quadgram is not fully decrypted
+	size_t quadgramCount = 0;
+	size_t scoredQuadgrams = 0;
+	double fitness = 0;
+
+	size_t pageRow = 0;
+
+	static int letterOf(char plain) {
+		return plain >= 'a' && plain <= 'z' ? plain - 'a' : -1;
+	}
+
+	// Rescores the quadgrams that contain ciphertext letter `c` after its mapping changed.
+	void rescore(char c) {
+		if (!scorer.isLoaded() || c < 'A' || c > 'Z') return;
+		const std::string& plaintext = session.getPlaintext();
+		for (size_t start : quadgramsOf[c - 'A']) {
+			if (!std::isnan(quadgramScores[start])) {
+				fitness -= quadgramScores[start];
+				--scoredQuadgrams;
+			}
+			int a = letterOf(plaintext[start]), b = letterOf(plaintext[start + 1]);
+			int x = letterOf(plaintext[start + 2]), y = letterOf(plaintext[start + 3]);
+			if (a < 0 || b < 0 || x < 0 || y < 0) {
+				quadgramScores[start] = std::numeric_limits<float>::quiet_NaN();
+				continue;
+			}
+			quadgramScores[start] = scorer(a, b, x, y);
+			fitness += quadgramScores[start];
+			++scoredQuadgrams;
+		}
+	}
+
+	int mappedLetters() const {
+		int mapped = 0;
+		for (char c = 'A'; c <= 'Z'; ++c) {
+			if (session.getCipher().inverseKey[c] != '-') ++mapped;
+		}
+		return mapped;
+	}
+
+	// Prints the changed rows that are on the current page, then the status line.
+	void show(const std::vector<size_t>& rows, std::chrono::steady_clock::time_point started) const {
+		std::vector<size_t> onPage;
+		for (size_t row : rows) {
+			if (row >= pageRow && row < pageRow + PAGE_ROWS) onPage.push_back(row);
+		}
+		if (!onPage.empty()) session.printRows(onPage);
+		if (rows.size() > onPage.size()) {
+			std::println("({} changed rows off this page)", rows.size() - onPage.size());
+		}
+		status(started);
+	}
+
+	void status(std::chrono::steady_clock::time_point started) const {
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+		if (scorer.isLoaded()) {
+			double mean = scoredQuadgrams > 0 ? fitness / scoredQuadgrams : 0;
+			std::println("{} of 26 letters mapped, fitness {:.3f} per quadgram over {} of {} quadgrams ({:.3f} ms)",
+				mappedLetters(), mean, scoredQuadgrams, quadgramCount, elapsed);
+		} else {
+			std::println("{} of 26 letters mapped ({:.3f} ms)", mappedLetters(), elapsed);
+		}
 	}
 
-	std::sort(freqArray.begin(), freqArray.end());
-	std::reverse(freqArray.begin(), freqArray.end());
+	// Applies the change, records what it overwrote and rescores the ciphertext letters it moved.
+	std::vector<size_t> perform(KeyChange& change) {
+		change.written.clear();
+		auto rows = change.c != '\0' ? session.addKey(change.p, change.c, &change.written) : session.removeKey(change.p, &change.written);
+		rescore(change.written);
+		return rows;
+	}
+
+	void rescore(const std::vector<SubstitutionCipher::Overwrite>& written) {
+		for (const auto& entry : written) {
+			if (entry.inverse) rescore(entry.index);
+		}
+	}
+
+	static std::string label(const KeyChange& change) {
+		std::string text = {change.p, '='};
+		if (change.c != '\0') text += change.c;
+		return text;
+	}
+
+	// `c` is '\0' to unmap `p`.
+	void apply(char p, char c) {
+		auto started = std::chrono::steady_clock::now();
+		if (p < 'a' || p > 'z' || (c != '\0' && (c < 'A' || c > 'Z'))) {
+			std::println(stderr, "Error: A mapping is a lowercase plaintext letter and an uppercase ciphertext letter, e.g. t=P, or t= to unmap t.");
+			return;
+		}
+		KeyChange change{p, c, {}};
+		auto rows = perform(change);
+		if (change.written.empty()) {
+			status(started);	// nothing changed, so there is nothing to undo
+			return;
+		}
+		undoStack.push_back(std::move(change));
+		redoStack.clear();
+		show(rows, started);
+	}
+
+	void undo() {
+		auto started = std::chrono::steady_clock::now();
+		if (undoStack.empty()) {
+			std::println(stderr, "Error: Nothing to undo.");
+			return;
+		}
+		KeyChange change = std::move(undoStack.back());
+		undoStack.pop_back();
+		auto rows = session.restore(change.written);
+		rescore(change.written);
+		std::println("undo {}", label(change));
+		redoStack.push_back(std::move(change));
+		show(rows, started);
+	}
 
+	void redo() {
+		auto started = std::chrono::steady_clock::now();
+		if (redoStack.empty()) {
+			std::println(stderr, "Error: Nothing to redo.");
+			return;
+		}
+		KeyChange change = std::move(redoStack.back());
+		redoStack.pop_back();
+		auto rows = perform(change);
+		std::println("redo {}", label(change));
+		undoStack.push_back(std::move(change));
+		show(rows, started);
+	}
+
+	void view(size_t row) {
+		pageRow = std::min(row, session.rowCount() - 1);
+		std::vector<size_t> rows;
+		for (size_t r = pageRow; r < std::min(session.rowCount(), pageRow + PAGE_ROWS); ++r) rows.push_back(r);
+		session.printRows(rows);
+	}
+
+	// The most frequent ciphertext n-grams next to their current decryption.
+	void printStats(const NGramCounter& counter, size_t top) const {
+		const SubstitutionCipher& cipher = session.getCipher();
+		for (auto [code, count] : counter.top(top)) {
+			std::string gram = counter.decode(code);
+			std::string plain = gram;
+			for (char& ch : plain) ch = cipher.inverseKey[ch];
+			std::print("{}={} {}\t", gram, plain, count);
+		}
+		std::println();
+	}
+
+	void printKey() const {
+		const SubstitutionCipher& cipher = session.getCipher();
+		std::string row;
+		for (char p = 'a'; p <= 'z'; ++p) {
+			char c = cipher.key[p];
+			row += c != '\0' && cipher.inverseKey[c] == p ? c : '.';
+		}
+		std::println("plain:  abcdefghijklmnopqrstuvwxyz");
+		std::println("cipher: {}", row);
+	}
+
+	// Proposes one mapping for an unmapped ciphertext letter, from the n-gram statistics:
+	//  - With nothing decided yet, the most frequent ciphertext trigram is taken to be "the".
+	//  - Otherwise every unmapped ciphertext letter C and unused plaintext letter p are tried on (a sample
+	//    of) the quadgrams where C is the only unknown. The pair whose quadgrams gain the most log10
+	//    probability over the average unused letter wins, so well-supported, clear-cut guesses come first.
+	//  - If no quadgram has C as its only unknown, the most frequent unmapped ciphertext letter is
+	//    matched with the most frequent unused English letter.
+	void suggest() const {
+		const SubstitutionCipher& cipher = session.getCipher();
+		const std::string& plaintext = session.getPlaintext();
+		std::array<bool, 26> used{};
+		for (char c = 'A'; c <= 'Z'; ++c) {
+			if (letterOf(cipher.inverseKey[c]) >= 0) used[letterOf(cipher.inverseKey[c])] = true;
+		}
+
+		if (mappedLetters() == 0) {
+			auto top = trigram.top(1);
+			std::string gram = top.empty() ? "" : trigram.decode(top[0].code);
+			if (!gram.empty() && gram[0] != gram[1] && gram[1] != gram[2] && gram[0] != gram[2]) {
+				std::println("suggest t={} (most frequent trigram {} read as \"the\", {} occurrences)", gram[0], gram, top[0].count);
+				return;
+			}
+		} else if (mappedLetters() <= 2) {
+			// Finish the "the" guess started above
+			auto top = trigram.top(1);
+			std::string gram = top.empty() ? "" : trigram.decode(top[0].code);
+			for (int i = 0; i < static_cast<int>(gram.size()) && cipher.inverseKey[gram[0]] == 't'; ++i) {
+				if (cipher.inverseKey[gram[i]] == '-' && !used["the"[i] - 'a']) {
+					std::println("suggest {}={} (most frequent trigram {} read as \"the\", {} occurrences)", "the"[i], gram[i], gram, top[0].count);
+					return;
+				}
+			}
+		}
+
+		double bestGain = 0;
+		size_t bestSupport = 0;
+		char bestP = 0, bestC = 0;
+		if (scorer.isLoaded()) {
+			for (char c = 'A'; c <= 'Z'; ++c) {
+				if (cipher.inverseKey[c] != '-') continue;
+
+				// Quadgrams where `c` is the only unknown; -1 marks the positions of `c`
+				std::vector<std::array<int, 4>> sample;
+				const auto& quadgrams = quadgramsOf[c - 'A'];
+				for (size_t start : std::span(quadgrams).first(std::min(quadgrams.size(), SUGGEST_SCAN))) {
+					std::array<int, 4> letters;
+					bool known = true;
+					for (int i = 0; i < 4; ++i) {
+						letters[i] = ciphertext[start + i] == c ? -1 : letterOf(plaintext[start + i]);
+						known = known && (letters[i] >= 0 || ciphertext[start + i] == c);
+					}
+					if (known) sample.push_back(letters);
+					if (sample.size() == SUGGEST_SAMPLE) break;
+				}
+				if (sample.empty()) continue;
+
+				std::array<double, 26> sums{};
+				int candidates = 0;
+				double total = 0;
+				for (int p = 0; p < 26; ++p) {
+					if (used[p]) continue;
+					for (const auto& q : sample) {
+						auto at = [&](int i) { return q[i] < 0 ? p : q[i]; };
+						sums[p] += scorer(at(0), at(1), at(2), at(3));
+					}
+					total += sums[p];
+					++candidates;
+				}
+				for (int p = 0; p < 26; ++p) {
+					if (used[p]) continue;
+					double gain = sums[p] - total / candidates;
+					if (gain > bestGain) {
+						bestGain = gain;
+						bestSupport = sample.size();
+						bestP = 'a' + p;
+						bestC = c;
+					}
+				}
+			}
+		}
+
+		if (bestP != 0) {
+			std::println("suggest {}={} (+{:.1f} log10 probability over {} quadgrams)", bestP, bestC, bestGain, bestSupport);
+			return;
+		}
+
+		for (auto [code, count] : monogram.top(26)) {
+			char c = monogram.decode(code)[0];
+			if (cipher.inverseKey[c] != '-') continue;
+			for (const char* p = ENGLISH_ORDER; *p != '\0'; ++p) {
+				if (used[*p - 'a']) continue;
+				std::println("suggest {}={} (most frequent unmapped letter, {} occurrences)", *p, c, count);
+				return;
+			}
+		}
+		std::println("Nothing to suggest: every ciphertext letter is mapped.");
+	}
+
+	static void help() {
+		std::println("Commands:");
+		std::println("  p=C         map plaintext letter p to ciphertext letter C (several per line are fine);");
+		std::println("              an earlier mapping of p or of C is dropped");
+		std::println("  p=          unmap plaintext letter p");
+		std::println("  undo, redo  step back or forward through the mappings");
+		std::println("  view [row]  show {} rows starting at `row`; later changes print the rows they touch on it", PAGE_ROWS);
+		std::println("  all         show the whole text");
+		std::println("  stats       ciphertext n-gram tables with their current decryption (on demand only)");
+		std::println("  suggest     propose the next mapping from the n-gram statistics");
+		std::println("  key         show the key");
+		std::println("  quit");
+	}
+
+public:
+	Workbench(std::string text, const QuadgramScorer& scorer, int cols = 100)
+		: session(text, cols), scorer(scorer), ciphertext(std::move(text)), monogram(1, 'A'), digram(2, 'A'), trigram(3, 'A') {
+		monogram.add(ciphertext);
+		digram.add(ciphertext);
+		trigram.add(ciphertext);
+
+		auto isLetter = [](char ch) { return ch >= 'A' && ch <= 'Z'; };
+		for (size_t start = 0; start + 4 <= ciphertext.length(); ++start) {
+			if (!std::all_of(ciphertext.begin() + start, ciphertext.begin() + start + 4, isLetter)) continue;
+			++quadgramCount;
+			for (size_t i = 0; i < 4; ++i) {
+				auto& list = quadgramsOf[ciphertext[start + i] - 'A'];
+				// Each quadgram is listed once per distinct letter it contains
+				if (list.empty() || list.back() != start) list.push_back(start);
+			}
+		}
+		quadgramScores.assign(ciphertext.length(), std::numeric_limits<float>::quiet_NaN());
+	}
+
+	// Reads commands from `in` until `quit` or the end of the input.
+	void run(std::istream& in) {
+		std::println("{} letters in {} rows; type `help` for the commands.", ciphertext.length(), session.rowCount());
+		view(0);
+		std::string line;
+		while (std::print("> "), std::fflush(stdout), std::getline(in, line)) {
+			std::istringstream words(line);
+			std::string word;
+			while (words >> word) {
+				if ((word.length() == 2 || word.length() == 3) && word[1] == '=') {
+					apply(word[0], word.length() == 3 ? word[2] : '\0');
+				} else if (word == "undo") {
+					undo();
+				} else if (word == "redo") {
+					redo();
+				} else if (word == "view") {
+					size_t row = pageRow;
+					if (words >> std::ws && std::isdigit(words.peek())) words >> row;
+					view(row);
+				} else if (word == "all") {
+					session.print();
+				} else if (word == "stats") {
+					printStats(monogram, 26);
+					printStats(digram, 12);
+					printStats(trigram, 10);
+				} else if (word == "suggest") {
+					auto started = std::chrono::steady_clock::now();
+					suggest();
+					status(started);
+				} else if (word == "key") {
+					printKey();
+				} else if (word == "help") {
+					help();
+				} else if (word == "quit") {
+					return;
+				} else {
+					std::println(stderr, "Error: Unknown command `{}`; type `help` for the commands.", word);
+				}
+			}
+		}
+		std::println();
+	}
+};
+
+void printFrequenciesSorted(const NGramCounter& counter, int cols) {
 	int printedCols = cols;
-	for (auto [v, k] : freqArray) {
-		std::print(stdout, "{0}: {1}\t", k, v);
+	for (auto [code, v] : counter.top(SIZE_MAX)) {
+		std::print(stdout, "{0}: {1}\t", counter.decode(code), v);
 		if (printedCols-- == 0) {
 			printedCols = cols;
 			std::println();
@@ -107,48 +891,84 @@ void printFrequenciesSorted(std::unordered_map<std::string, int> freqMap, int co
 	std::println();
 }
 
-int main() {
+// Usage: main [--repl [ciphertext-file]]
+// With --repl, opens the interactive workbench on the file (letters are uppercased, everything else
+// is dropped) or on the built-in ciphertext; otherwise runs the scripted walkthrough below.
+int main(int argc, char* argv[]) {
 	std::string ciphertext = "RABXDPSTJXQSFPPFQEJVSXPGSMCMPSLPGSFPPFQESXJXFWVSXMFXCPXRSMFIIHJMMRBISESCMDAPRIRPTRAWMPGSQJXXSQPESCPGSFPPFQESXMSISQPMPGSESCPJPXCXFAWJLICFMMDLRANPGFPPGSFPPFQESXQFAWRMPRANDRMGPGSQJXXSQPFAWPGSRAQJXXSQPESCFTPSXPXRFIMJASPGRANRYJDIWIRESPJLSAPRJARMPGFPPXCRANHFMMYJXWMJTMJLSJASMFQQJDAPRMAJPFBXDPSTJXQSFPPFQEPGFPRMUDMPGRPPXRFIRAPGSBXDPSTJXQSFPPFQEYSTJQDMJAPGSESCNSASXFPSWTJXPGSSAQXCHPRJAFINJXRPGL";
 
-	SubstitutionCipher sc;
-	std::unordered_map<std::string, int> monogram, digram, trigram;
+	if (argc >= 2 && std::string_view(argv[1]) == "--repl") {
+		if (argc >= 3) {
+			std::ifstream inFile(argv[2]);
+			if (!inFile) {
+				std::println(stderr, "Error: Unable to open {}.", argv[2]);
+				return 1;
+			}
+			ciphertext.clear();
+			char ch;
+			while (inFile.get(ch)) {
+				if (std::isalpha(static_cast<unsigned char>(ch))) ciphertext += static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+			}
+		}
+		QuadgramScorer scorer;
+		Workbench workbench(ciphertext, scorer);
+		workbench.run(std::cin);
+		return 0;
+	}
+
+	NGramCounter monogram(1, 'A'), digram(2, 'A'), trigram(3, 'A');
 
 	// Populate monogram, digram, and trigram frequencies for frequency analysis.
-	for (int i = 0; i < ciphertext.length(); ++i) monogram[ciphertext.substr(i, 1)]++;
-	for (int i = 0; i < ciphertext.length() - 1; ++i) digram[ciphertext.substr(i, 2)]++;
-	for (int i = 0; i < ciphertext.length() - 2; ++i) trigram[ciphertext.substr(i, 3)]++;
+	monogram.add(ciphertext);
+	digram.add(ciphertext);
+	trigram.add(ciphertext);
 
 	printFrequenciesSorted(monogram, 13);
 	printFrequenciesSorted(digram, 11);
 	printFrequenciesSorted(trigram, 9);
 	
 	// Performing Frequency Analysis based on statistical data of the English Language.
-	// Also, seeing the incremental changes after deciphering. 
-	sc.addDecryptAndPrint('t', 'P', ciphertext);
-	sc.addDecryptAndPrint('e', 'S', ciphertext);
-	sc.addDecryptAndPrint('h', 'G', ciphertext);
-	sc.addDecryptAndPrint('a', 'F', ciphertext);
-	sc.addDecryptAndPrint('c', 'Q', ciphertext);
-	sc.addDecryptAndPrint('k', 'E', ciphertext);
-	sc.addDecryptAndPrint('r', 'X', ciphertext);
-	sc.addDecryptAndPrint('o', 'J', ciphertext);
-	sc.addDecryptAndPrint('b', 'B', ciphertext);
-	sc.addDecryptAndPrint('u', 'D', ciphertext);
-	sc.addDecryptAndPrint('i', 'R', ciphertext);
-	sc.addDecryptAndPrint('n', 'A', ciphertext);
-	sc.addDecryptAndPrint('f', 'T', ciphertext);
-	sc.addDecryptAndPrint('d', 'W', ciphertext);
-	sc.addDecryptAndPrint('v', 'V', ciphertext);
-	sc.addDecryptAndPrint('s', 'M', ciphertext);
-	sc.addDecryptAndPrint('y', 'C', ciphertext);
-	sc.addDecryptAndPrint('m', 'L', ciphertext);
-	sc.addDecryptAndPrint('l', 'I', ciphertext);
-	sc.addDecryptAndPrint('p', 'H', ciphertext);
-	sc.addDecryptAndPrint('g', 'N', ciphertext);
-	sc.addDecryptAndPrint('w', 'Y', ciphertext);
-	sc.addDecryptAndPrint('j', 'U', ciphertext);
-
-	auto test = sc.encrypt("thisisgreatz"); // Error
+	// Also, seeing the incremental changes after deciphering: only the rows a mapping changes are reprinted.
+	DecryptionSession session(ciphertext);
+	session.addKeyAndPrint('t', 'P');
+	session.addKeyAndPrint('e', 'S');
+	session.addKeyAndPrint('h', 'G');
+	session.addKeyAndPrint('a', 'F');
+	session.addKeyAndPrint('c', 'Q');
+	session.addKeyAndPrint('k', 'E');
+	session.addKeyAndPrint('r', 'X');
+	session.addKeyAndPrint('o', 'J');
+	session.addKeyAndPrint('b', 'B');
+	session.addKeyAndPrint('u', 'D');
+	session.addKeyAndPrint('i', 'R');
+	session.addKeyAndPrint('n', 'A');
+	session.addKeyAndPrint('f', 'T');
+	session.addKeyAndPrint('d', 'W');
+	session.addKeyAndPrint('v', 'V');
+	session.addKeyAndPrint('s', 'M');
+	session.addKeyAndPrint('y', 'C');
+	session.addKeyAndPrint('m', 'L');
+	session.addKeyAndPrint('l', 'I');
+	session.addKeyAndPrint('p', 'H');
+	session.addKeyAndPrint('g', 'N');
+	session.addKeyAndPrint('w', 'Y');
+	session.addKeyAndPrint('j', 'U');
+
+	// The same attack without an analyst: simulated annealing on English quadgram fitness.
+	QuadgramScorer scorer;
+	if (scorer.isLoaded()) {
+		SubstitutionSolver solver(scorer, ciphertext);
+		SolveBudget budget;
+		budget.time = std::chrono::milliseconds(500);
+		budget.targetFitness = -4.7;	// about what ordinary English text scores against quadgrams.txt
+		SolvedKey solved = solver.solveParallel(budget);
+		std::println("Simulated annealing found a key with fitness {:.2f}:", solved.fitness);
+		SubstitutionCipher automatic;
+		solved.applyTo(automatic);
+		automatic.decryptAndPrint(ciphertext);
+	}
+
+	auto test = session.getCipher().encrypt("thisisgreatz"); // Error
 	if (test != std::nullopt) std::println("{}", *test); 
 	return 0;
 }
@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+# Rebuilds quadgrams.txt, the English statistics used by QuadgramScorer.
+#
+# Usage: make-quadgrams.py [corpus.txt ...] > quadgrams.txt
+#        (default corpus: corpus/isaac-newton-opticks.txt)
+#
+# Every corpus file is upper-cased and stripped of everything but the letters A-Z, the way the
+# solver treats a ciphertext, and the quadgrams of that letter stream are counted, word
+# boundaries included. The output is one "ABCD count" line per quadgram seen at least
+# MIN_COUNT times, most frequent first.
+#
+# Corpus: Isaac Newton, "Opticks" (4th edition, 1730), Project Gutenberg eBook #33504,
+# public domain; the copy in corpus/ is the one shipped as Go's src/testdata, without the
+# Project Gutenberg header and footer.
+
+import collections
+import os
+import re
+import sys
+
+MIN_COUNT = 1
+DEFAULT_CORPUS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "corpus", "isaac-newton-opticks.txt")
+
+
+def main():
+    paths = sys.argv[1:] or [DEFAULT_CORPUS]
+    counts = collections.Counter()
+    for path in paths:
+        with open(path, encoding="utf-8", errors="ignore") as corpus:
+            letters = re.sub("[^A-Z]", "", corpus.read().upper())
+        counts.update(letters[i:i + 4] for i in range(len(letters) - 3))
+
+    for quadgram, count in sorted(counts.items(), key=lambda item: (-item[1], item[0])):
+        if count >= MIN_COUNT:
+            print(quadgram, count)
+
+
+if __name__ == "__main__":
+    main()
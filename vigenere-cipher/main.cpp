@@ -12,27 +12,22 @@
 #include <numeric>			// for std::gcd
 #include <fstream>			// to process probability file
 
+#include "../common/histogram.hpp"
+#include "../common/ngram.hpp"
+
 // Utility function to print frequencies of most frequent {mono,bi,tri,four}grams.
-void printFrequenciesSorted(std::unordered_map<std::string, int> freqMap, int cols, std::string label, int top = 15) {
+void printFrequenciesSorted(const NGramCounter& counter, int cols, std::string label, int top = 15) {
 	std::println(" * {} Frequencies", label);
 	std::print("\t");
-	std::vector<std::pair<int, std::string>> freqArray;
-	for (auto [k, v] : freqMap) {
-		freqArray.push_back({v, k});
-	}
-
-	std::sort(freqArray.begin(), freqArray.end());
-	std::reverse(freqArray.begin(), freqArray.end());
 
 	int printedCols = cols;
-	for (auto [v, k] : freqArray) {
-		std::print(stdout, "{0}: {1}\t", k, v);
+	for (auto [code, v] : counter.top(top)) {
+		std::print(stdout, "{0}: {1}\t", counter.decode(code), v);
 		if (printedCols-- == 0) {
 			printedCols = cols;
 			std::println();
 			std::print("\t");
 		}
-		if (--top == 0) break;
 	}
 
 	std::println();
@@ -222,9 +217,10 @@ public:
 		// binFreq[i][j] denotes the frequency of j'th character in i'th bin
 		int ctLength = ciphertext.size();
 		for (int i = 0; i < std::min(keyLength, ctLength); ++i) {
-			for (int k = i; k < ctLength; k += keyLength) {
-				binFreq[i][ciphertext[k] - 'a'] += 1;
-			}
+			ByteHistogram bin;
+			bin.addStrided(ciphertext, i, keyLength);
+			auto letters = bin.letters<26>('a');
+			binFreq[i].assign(letters.begin(), letters.end());
 		}
 
 		std::string deducedKey;
@@ -246,11 +242,11 @@ int main() {
 	std::println();
 	std::string ciphertext = "qwgbnnkywgbonsaqcjkbjbrorhjhnonzglxmlmmnxsqvrbochmqrxycyaqrfjbucxdkprqxrqaaaqzghpkojqqobnluuydawbixrvjwwozhvbnbubdqxpnufkdoadcorlmwcynodxhbewqntjjiqwgbnnkyyhopdqxpzzdrdqhujyxcbdsfxuunonzglxmlmppqqfsqlyniewqxjbqowhljbyzszowubqorryqqevdfwwtyrmxzlbmllqkkumxslxjxzfgxewiexfdabjuqfqdjjfkdvyjdefziajdpdqbidstizppnhfkzkacxqudri";
 
-	std::unordered_map<std::string, int> monogram, digram, trigram, fourgram;
+	NGramCounter trigram(3), fourgram(4);
 
 	// Populate trigram and fourgram frequencies for Kasiski's Test.
-	for (int i = 0; i < ciphertext.length() - 2; ++i) trigram[ciphertext.substr(i, 3)]++;
-	for (int i = 0; i < ciphertext.length() - 3; ++i) fourgram[ciphertext.substr(i, 4)]++;
+	trigram.add(ciphertext);
+	fourgram.add(ciphertext);
 
 	printFrequenciesSorted(trigram, 11, "Trigram");
 	printFrequenciesSorted(fourgram, 10, "Fourgram");